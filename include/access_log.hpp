@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <limhamn/http/http_server.hpp>
+
+namespace ff {
+    struct AccessRecord {
+        int64_t timestamp{0}; // unix millis
+        int64_t duration{0}; // microseconds
+        int http_status{0};
+        char ip_address[46]{};
+        char method[8]{};
+        char endpoint[256]{}; // truncated if longer
+    };
+
+    /* Access log with a bounded lock-free multi-producer, single-consumer ring
+     * buffer. Request threads only copy a fixed-size record into a slot; formatting
+     * and file I/O happen on a background writer thread, which flushes a batch once
+     * it is large enough or old enough. Records that do not fit are counted and
+     * dropped rather than blocking the request.
+     */
+    class AccessLog {
+        struct Slot {
+            std::atomic<std::size_t> sequence{0};
+            AccessRecord record{};
+        };
+
+        std::unique_ptr<Slot[]> slots{};
+        std::size_t mask{0};
+        alignas(64) std::atomic<std::size_t> enqueue_position{0};
+        alignas(64) std::size_t dequeue_position{0};
+        std::atomic<uint64_t> dropped{0}; // since the writer last reported it; the total is in ff::metrics
+        std::atomic<bool> running{false};
+        std::thread writer{};
+
+        bool pop(AccessRecord& record);
+        void run();
+    public:
+        explicit AccessLog() = default;
+        ~AccessLog();
+
+        void start();
+        void stop();
+        void push(const limhamn::http::server::request& request, int http_status, int64_t duration);
+    };
+
+    inline AccessLog access_log{};
+} // namespace ff
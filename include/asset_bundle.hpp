@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <ctime>
+#include <compression.hpp>
+#include <limhamn/http/http_server.hpp>
+
+namespace ff {
+    struct AssetVariant {
+        std::shared_ptr<const std::string> data{}; // shared between bundles; copied into each response
+        std::string etag{};
+    };
+
+    struct Asset {
+        std::array<AssetVariant, 4> variants{}; // indexed by ContentEncoding
+        std::string content_type{};
+        bool compressible{false};
+        std::string last_modified{};
+        std::string cache_control{};
+        std::string source_file{};
+        std::time_t modified_at{0};
+    };
+
+    // source_file may be empty for contents that are not read from a file
+    Asset make_asset(const std::string& source_file, std::string contents, const std::string& content_type, const std::string& cache_control,
+        CompressionLevel level = CompressionLevel::Best);
+
+    /* Static files loaded once at startup and served from memory. The bundle is
+     * immutable once loaded; reloading builds a new one and swaps it in, so
+     * requests in flight keep the one they started with.
+     */
+    class AssetBundle {
+        using Assets = std::unordered_map<std::string, Asset>;
+        std::shared_ptr<const Assets> assets{std::make_shared<const Assets>()};
+        std::mutex load_mutex{};
+
+        [[nodiscard]] bool is_stale(const Asset& asset) const;
+    public:
+        explicit AssetBundle() = default;
+        ~AssetBundle() = default;
+
+        void load();
+        [[nodiscard]] std::shared_ptr<const Asset> find(const std::string& path);
+        [[nodiscard]] limhamn::http::server::response serve(const limhamn::http::server::request& request, const Asset& asset) const;
+        [[nodiscard]] limhamn::http::server::response serve(const limhamn::http::server::request& request, const std::string& path);
+    };
+
+    inline AssetBundle asset_bundle{};
+} // namespace ff
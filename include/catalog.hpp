@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <database.hpp>
+#include <listing_filter.hpp>
+#include <pagination.hpp>
+
+namespace ff {
+    /* A set of rows of a catalog, one bit per row. A catalog holds every upload of its
+     * table, a few thousand at most, so plain 64-bit words are smaller and faster to
+     * combine than compressed containers would be.
+     */
+    class Bitmap {
+        std::vector<uint64_t> words{};
+        std::size_t size{0};
+    public:
+        explicit Bitmap() = default;
+        explicit Bitmap(std::size_t size, bool value = false);
+
+        void set(std::size_t row);
+        [[nodiscard]] bool test(std::size_t row) const;
+        Bitmap& operator&=(const Bitmap& other);
+        Bitmap& operator|=(const Bitmap& other);
+        [[nodiscard]] std::vector<uint32_t> get_rows() const;
+    };
+
+    struct CatalogPage {
+        std::vector<int64_t> ids{}; // in the requested order
+        std::string next_cursor{}; // empty at the end of the listing
+    };
+
+    /* The listing columns of forwarders or sandbox files in memory, one array per
+     * column, so listings are filtered without reading or parsing any JSON. Text columns
+     * are interned, flags are bitmaps, submitted is kept sorted for ranges and every
+     * category has a bitmap of the rows in it. Each use checks the catalog generation of
+     * the table (see ff::touch_catalog()), and a refresh only parses the JSON of rows
+     * whose version changed. Searches are left to the full-text index.
+     */
+    class Catalog {
+        struct Column {
+            std::unordered_map<std::string, uint32_t> values{}; // 0 is NULL
+            std::vector<uint32_t> rows{};
+
+            void add(const std::string& value);
+            [[nodiscard]] Bitmap find(const std::string& value, bool match_null = false) const;
+        };
+
+        // what a row contributes from its JSON, reused for as long as its version holds
+        struct Document {
+            int64_t version{-1};
+            ListingDocument listing{};
+        };
+
+        struct Data {
+            int64_t generation{-1};
+            std::vector<int64_t> ids{}; // ascending; a row is an index into this and every column
+            std::unordered_map<std::string, uint32_t> identifiers{};
+            std::unordered_map<int64_t, Document> documents{};
+            Column uploader{};
+            Column author{};
+            Column location{};
+            Column title_id{};
+            Column title{};
+            Column filename{};
+            Bitmap listed{};
+            Bitmap reviewed{};
+            Bitmap needs_review{};
+            Bitmap forwarder{};
+            Bitmap channel{};
+            Bitmap vwii{};
+            Bitmap not_vwii{};
+            std::vector<std::pair<int64_t, uint32_t>> submitted{}; // sorted, rows without one are left out
+            std::vector<int64_t> downloads{};
+            std::vector<int64_t> rating{};
+            std::unordered_map<std::string, Bitmap> categories{};
+        };
+
+        const std::string table{};
+        std::shared_ptr<const Data> data{std::make_shared<const Data>()};
+        std::mutex refresh_mutex{};
+
+        [[nodiscard]] std::shared_ptr<const Data> build(database& db, int64_t generation, const Data& previous) const;
+        [[nodiscard]] std::shared_ptr<const Data> get(database& db);
+    public:
+        explicit Catalog(std::string table);
+        ~Catalog() = default;
+        Catalog(const Catalog&) = delete;
+        Catalog& operator=(const Catalog&) = delete;
+
+        void refresh(database& db);
+        [[nodiscard]] CatalogPage select(database& db, const ListingFilter& filter, const PageRequest& page);
+        /* Selects the id, version, json and columns of the rows of a page and passes them
+         * to handle in the order of the page. Rows deleted since the page was selected
+         * are skipped.
+         */
+        void for_each_row(database& db, const CatalogPage& page, const std::vector<std::string>& columns,
+            const std::function<void(const std::unordered_map<std::string, std::string>&)>& handle) const;
+    };
+
+    inline Catalog forwarder_catalog{"forwarders"};
+    inline Catalog sandbox_catalog{"sandbox"};
+} // namespace ff
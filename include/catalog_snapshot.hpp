@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <asset_bundle.hpp>
+#include <database.hpp>
+
+namespace ff {
+    /* The accepted forwarders as anonymous visitors browse them, i.e. the response to
+     * /api/get_forwarders when ff::ListingFilter::is_default_browse() holds, serialized
+     * and compressed ahead of time and served like a static asset. Requests only look
+     * up the catalog generation of forwarders (see ff::touch_catalog()) and rebuild the
+     * snapshot when it moved; a rebuild only fetches and serializes the rows whose
+     * version or counters changed, and reuses the rest from the previous snapshot.
+     * Writes that move the generation without changing any listed row, such as counted
+     * downloads, keep the previous body and its compressed variants.
+     */
+    class CatalogSnapshot {
+        struct Entry {
+            int64_t version{0};
+            int64_t rating_sum{0};
+            int64_t rating_count{0};
+            int64_t comment_count{0};
+            std::shared_ptr<const std::string> json{}; // nullptr if the row is not listed
+        };
+
+        struct Snapshot {
+            int64_t generation{-1};
+            std::shared_ptr<const Asset> asset{};
+            std::unordered_map<int64_t, Entry> entries{};
+            std::vector<int64_t> order{}; // the ids of the accepted rows, in the order of the body
+        };
+
+        std::shared_ptr<const Snapshot> snapshot{std::make_shared<const Snapshot>()};
+        std::mutex build_mutex{};
+
+        [[nodiscard]] static std::shared_ptr<const Snapshot> build(database& db, int64_t generation, const Snapshot& previous);
+    public:
+        explicit CatalogSnapshot() = default;
+        ~CatalogSnapshot() = default;
+        CatalogSnapshot(const CatalogSnapshot&) = delete;
+        CatalogSnapshot& operator=(const CatalogSnapshot&) = delete;
+
+        [[nodiscard]] std::shared_ptr<const Asset> get(database& db);
+    };
+
+    inline CatalogSnapshot catalog_snapshot{};
+} // namespace ff
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+
+namespace ff {
+    enum class ContentEncoding {
+        Identity,
+        Gzip,
+        Brotli,
+        Zstd,
+    };
+
+    enum class CompressionLevel {
+        Best, // for contents compressed once at startup
+        Fast, // for contents rebuilt while serving requests
+    };
+
+    std::string gzip_compress(const std::string& data, CompressionLevel level = CompressionLevel::Best);
+#ifdef FF_ENABLE_BROTLI
+    std::string brotli_compress(const std::string& data, CompressionLevel level = CompressionLevel::Best);
+#endif
+#ifdef FF_ENABLE_ZSTD
+    std::string zstd_compress(const std::string& data, CompressionLevel level = CompressionLevel::Best);
+#endif
+    bool is_compressible(const std::string& content_type);
+    ContentEncoding negotiate_encoding(const std::string& accept_encoding);
+    std::string get_encoding_name(ContentEncoding encoding);
+} // namespace ff
@@ -1,70 +1,110 @@
 #pragma once
 
-#define LIMHAMN_DATABASE_IMPL
-#include <limhamn/database/database.hpp>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+#include <metrics.hpp>
+#if FF_ENABLE_SQLITE
+#include <sqlite3.h>
+#endif
+#if FF_ENABLE_POSTGRESQL
+#include <libpq-fe.h>
+#endif
 
 namespace ff {
+    using DatabaseParameter = std::variant<std::monostate, int64_t, std::string>; // std::monostate binds NULL
+
+    /* A single SQLite or PostgreSQL connection. Statements are prepared once and kept
+     * in a per-connection LRU keyed by their SQL text, so the fixed queries run on
+     * every request are parsed and planned only the first time a connection sees
+     * them. Placeholders are written as '?' for both backends.
+     */
     class database {
+        struct Statement {
+            std::string sql{};
 #if FF_ENABLE_SQLITE
-        limhamn::database::sqlite3_database sqlite{};
-#define SQLITE_HANDLE this->sqlite
-#endif
-#if FF_ENABLE_POSTGRESQL
-        limhamn::database::postgresql_database postgres{};
-#define POSTGRES_HANDLE this->postgres
+            sqlite3_stmt* sqlite{nullptr};
 #endif
-#ifndef SQLITE_HANDLE
-#define SQLITE_HANDLE this->postgres
+            std::string postgres{}; // name of the prepared statement
+        };
+
+#if FF_ENABLE_SQLITE
+        sqlite3* sqlite{nullptr};
 #endif
-#ifndef POSTGRES_HANDLE
-#define POSTGRES_HANDLE this->sqlite
+#if FF_ENABLE_POSTGRESQL
+        PGconn* postgres{nullptr};
 #endif
 
         bool enabled_type = false; // false = sqlite, true = postgres
-    public:
-        explicit database(bool type) : enabled_type(type) {}
-        std::vector<std::unordered_map<std::string, std::string>> query(const std::string& query) {
-            if (!this->enabled_type) {
-                return SQLITE_HANDLE.query(query);
-            } else {
-                return POSTGRES_HANDLE.query(query);
+        std::list<Statement> statements{}; // most recently used first
+        std::unordered_map<std::string_view, std::list<Statement>::iterator> statement_index{};
+        uint64_t statement_counter{0};
+        std::size_t affected_rows{0};
+
+        class Timer {
+            DatabaseOperation operation{};
+            std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+        public:
+            explicit Timer(const DatabaseOperation operation) : operation(operation) {}
+            ~Timer() {
+                metrics.observe_database(this->operation, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - this->start).count());
             }
-        }
-        bool exec(const std::string& query) {
-            if (!this->enabled_type) {
-                return SQLITE_HANDLE.exec(query);
+        };
+
+        template <typename T>
+        static DatabaseParameter to_parameter(const T& value) {
+            if constexpr (std::is_null_pointer_v<T>) {
+                return std::monostate{};
+            } else if constexpr (std::is_integral_v<T> || std::is_enum_v<T>) {
+                return static_cast<int64_t>(value);
             } else {
-                return POSTGRES_HANDLE.exec(query);
+                return std::string{value};
             }
         }
-        template <typename... Args>
-        std::vector<std::unordered_map<std::string, std::string>> query(const std::string& query, Args... args) {
-            if (!this->enabled_type) {
-                return SQLITE_HANDLE.query(query, args...);
-            } else {
-                return POSTGRES_HANDLE.query(query, args...);
-            }
+
+        Statement* prepare(const std::string& query);
+        void finalize(Statement& statement);
+        bool run(const std::string& query, const std::vector<DatabaseParameter>& parameters, std::vector<std::unordered_map<std::string, std::string>>* rows);
+    public:
+        explicit database(bool type) : enabled_type(type) {}
+        ~database();
+        database(const database&) = delete;
+        database& operator=(const database&) = delete;
+
+        void open_sqlite(const std::string& file);
+        void open_postgres(const std::string& host, const std::string& username, const std::string& password, const std::string& database, int port);
+
+        std::vector<std::unordered_map<std::string, std::string>> query(const std::string& query, const std::vector<DatabaseParameter>& parameters = {}) {
+            const Timer timer{DatabaseOperation::Query};
+            std::vector<std::unordered_map<std::string, std::string>> rows{};
+            this->run(query, parameters, &rows);
+            return rows;
+        }
+        bool exec(const std::string& query, const std::vector<DatabaseParameter>& parameters = {}) {
+            const Timer timer{DatabaseOperation::Exec};
+            return this->run(query, parameters, nullptr);
         }
         template <typename... Args>
-        bool exec(const std::string& query, Args... args) {
-            if (!this->enabled_type) {
-                return SQLITE_HANDLE.exec(query, args...);
-            } else {
-                return POSTGRES_HANDLE.exec(query, args...);
-            }
+        std::vector<std::unordered_map<std::string, std::string>> query(const std::string& query, const Args&... args) {
+            return this->query(query, std::vector<DatabaseParameter>{to_parameter(args)...});
         }
-        [[nodiscard]] bool good() const {
-            return this->enabled_type ? POSTGRES_HANDLE.good() : SQLITE_HANDLE.good();
+        template <typename... Args>
+        bool exec(const std::string& query, const Args&... args) {
+            return this->exec(query, std::vector<DatabaseParameter>{to_parameter(args)...});
         }
-#if FF_ENABLE_SQLITE
-        limhamn::database::sqlite3_database& get_sqlite() {
-            return this->sqlite;
+        // rows changed by the last exec()
+        [[nodiscard]] std::size_t changes() const {
+            return this->affected_rows;
         }
-#endif
-#if FF_ENABLE_POSTGRESQL
-        limhamn::database::postgresql_database& get_postgres() {
-            return this->postgres;
+        [[nodiscard]] bool good() const;
+        [[nodiscard]] bool is_postgres() const {
+            return this->enabled_type;
         }
-#endif
     };
 } // namespace ff
@@ -0,0 +1,8 @@
+#pragma once
+
+namespace ff {
+    enum class DatabaseOperation {
+        Query,
+        Exec,
+    };
+} // namespace ff
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <database.hpp>
+#include <user_properties_struct.hpp>
+
+namespace ff {
+    struct DownloadEvent {
+        std::string file_id{};
+        std::string username{};
+        std::string ip_address{};
+        std::string user_agent{};
+        int64_t timestamp{0}; // unix millis
+    };
+
+    /* Records downloads without touching the database on the request path. Events
+     * are queued in memory and a background thread, with a connection of its own,
+     * writes them to download_events and adds them to files.downloads in one
+     * transaction per batch. Events that do not fit in the queue are counted and
+     * dropped rather than blocking the download.
+     */
+    class DownloadLog {
+        std::unique_ptr<database> db{};
+        std::vector<DownloadEvent> events{};
+        std::mutex mutex{};
+        std::condition_variable condition{};
+        uint64_t dropped{0};
+        bool running{false};
+        std::thread writer{};
+
+        void flush(std::vector<DownloadEvent>& batch);
+        void run();
+    public:
+        explicit DownloadLog() = default;
+        ~DownloadLog();
+
+        void start(std::unique_ptr<database> connection);
+        void stop();
+        void push(const std::string& file_id, const UserProperties& properties);
+    };
+
+    inline DownloadLog download_log{};
+} // namespace ff
@@ -0,0 +1,9 @@
+#pragma once
+
+namespace ff {
+    enum class DownloadOffload {
+        None,
+        XAccelRedirect,
+        XSendfile,
+    };
+} // namespace ff
@@ -12,6 +12,10 @@ namespace ff {
     limhamn::http::server::response handle_virtual_favicon_endpoint(const limhamn::http::server::request& request, database& db);
     limhamn::http::server::response handle_virtual_stylesheet_endpoint(const limhamn::http::server::request& request, database& db);
     limhamn::http::server::response handle_virtual_script_endpoint(const limhamn::http::server::request& request, database& db);
+    limhamn::http::server::response handle_download_endpoint(const limhamn::http::server::request& request, database& db);
+    limhamn::http::server::response handle_activate_endpoint(const limhamn::http::server::request& request, database& db);
+    limhamn::http::server::response handle_not_found_endpoint(const limhamn::http::server::request& request, database& db);
+    limhamn::http::server::response handle_metrics_endpoint(const limhamn::http::server::request& request, database& db);
     limhamn::http::server::response handle_api_try_register_endpoint(const limhamn::http::server::request& request, database& db);
     limhamn::http::server::response handle_api_try_login_endpoint(const limhamn::http::server::request& request, database& db);
     limhamn::http::server::response handle_try_upload_forwarder_endpoint(const limhamn::http::server::request& request, database& db);
@@ -33,6 +37,7 @@ namespace ff {
     limhamn::http::server::response handle_api_comment_file_endpoint(const limhamn::http::server::request& request, database& db);
     limhamn::http::server::response handle_api_delete_comment_forwarder_endpoint(const limhamn::http::server::request& request, database& db);
     limhamn::http::server::response handle_api_delete_comment_file_endpoint(const limhamn::http::server::request& request, database& db);
+    limhamn::http::server::response handle_api_get_comments_endpoint(const limhamn::http::server::request& request, database& db);
     limhamn::http::server::response handle_api_stay_logged_in(const limhamn::http::server::request& request, database& db);
     limhamn::http::server::response handle_api_try_logout_endpoint(const limhamn::http::server::request& request, database& db);
 
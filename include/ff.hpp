@@ -1,6 +1,10 @@
 #pragma once
 
 #include <string>
+#include <memory>
+#include <atomic>
+#include <ctime>
+#include <functional>
 #include <settings.hpp>
 #include <account_creation_status_enum.hpp>
 #include <upload_status_enum.hpp>
@@ -10,8 +14,9 @@
 #include <file_construct_struct.hpp>
 #include <retrieved_file_struct.hpp>
 #include <user_properties_struct.hpp>
-#include <cache_manager.hpp>
+#include <json_patch_struct.hpp>
 #include <database.hpp>
+#include <nlohmann/json.hpp>
 #define LIMHAMN_LOGGER_IMPL
 #include <limhamn/logger/logger.hpp>
 #define LIMHAMN_HTTP_SERVER_IMPL
@@ -20,17 +25,28 @@
 
 namespace ff {
     inline limhamn::logger::logger logger{};
-    inline CacheManager cache_manager{};
     inline bool fatal{false};
     inline static const std::string virtual_stylesheet_path{"/css/index.css"};
     inline static const std::string virtual_font_path{"/fonts/font.ttf"};
     inline static const std::string virtual_favicon_path{"/img/favicon.svg"};
     inline static const std::string virtual_script_path{"/js/index.js"};
-    inline bool needs_setup{false};
+    inline std::atomic<bool> needs_setup{false}; // a cache of this process; see ff::check_needs_setup()
+    inline bool is_supervised_worker{false}; // forked by ff::run_supervisor(), which has already set up the database
 
     void start_server();
+    void run_supervisor(std::size_t workers);
     std::string get_json_from_table(database& db, const std::string& table, const std::string& key, const std::string& value);
+    std::shared_ptr<const nlohmann::json> get_parsed_json_from_table(database& db, const std::string& table, const std::string& key, const std::string& value);
+    std::shared_ptr<const nlohmann::json> get_parsed_json_from_row(const std::string& table, const std::unordered_map<std::string, std::string>& row);
     bool set_json_in_table(database& db, const std::string& table, const std::string& key, const std::string& value, const std::string& json);
+    bool update_json_in_table(database& db, const std::string& table, const std::string& key, const std::string& value, const std::function<bool(nlohmann::json&)>& update);
+    bool patch_json_in_table(database& db, const std::string& table, const std::string& key, const std::string& value, const std::vector<JsonPatch>& patches);
+    bool insert_json_into_table(database& db, const std::string& table, const std::string& key, const std::string& value, const std::string& json);
+    void touch_catalog(database& db, const std::string& table);
+    int64_t get_catalog_generation(database& db, const std::string& table);
+    bool set_rating(database& db, const std::string& table, const std::string& identifier, const std::string& username, int64_t rating);
+    bool insert_comment(database& db, const std::string& table, const std::string& identifier, const std::string& username, const std::string& comment);
+    bool delete_comment(database& db, const std::string& table, const std::string& identifier, int64_t id);
     void insert_into_user_table(database& database, const std::string& username, const std::string& password,
         const std::string& key, const std::string& email, int64_t created_at, int64_t updated_at, const std::string& ip_address,
         const std::string& user_agent, UserType user_type, const std::string& json);
@@ -49,13 +65,18 @@ namespace ff {
     void prepare_wd();
     Settings load_settings(const std::string& _config_file);
     std::string generate_default_config();
+    std::unique_ptr<database> open_database();
     void setup_database(database& database);
     std::string open_file(const std::string& file_path);
+    std::string open_file(const std::string& file_path, std::uintmax_t offset, std::uintmax_t length);
+    std::string get_header(const limhamn::http::server::request& request, const std::string& name);
+    std::string http_date(std::time_t time);
     bool username_is_stored(const limhamn::http::server::request& request);
     bool ensure_valid_creds(database& database, const std::string& username, const std::string& password);
     bool verify_key(database& database, const std::string& username, const std::string& key);
     bool user_is_verified(database& database, const std::string& username);
     bool ensure_admin_account_exists(database& database);
+    bool check_needs_setup(database& database);
     int get_user_id(database& database, const std::string& username);
     UserType get_user_type(database& database, const std::string& username);
     bool validate_image(const std::string& path);
@@ -70,7 +91,7 @@ namespace ff {
     void update_to_latest(database& db);
 
     std::string upload_file(database& db, const ff::FileConstruct& c);
-    RetrievedFile download_file(database& db, const ff::UserProperties& prop, const std::string& file_key);
+    RetrievedFile get_file(database& db, const std::string& file_key);
     std::string get_path_from_file(database& db, const std::string& file_key);
     void create_patched_dol(const std::string& path, const std::string& output_path);
 
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+
+namespace ff {
+    struct CachedJson {
+        int64_t id{-1}; // id of the row the document was read from
+        int64_t version{-1}; // version of the row the document was read from
+        std::shared_ptr<const nlohmann::json> json{};
+    };
+
+    /* Parsed JSON documents of table rows, keyed by table, key column and value.
+     * Every write of a row bumps its version column, and a document is only used
+     * while the row still has the id and version it was read with, so a stale entry
+     * is never returned, even when another worker process changed the row. Entries
+     * are evicted least recently used first once settings.json_cache_size bytes,
+     * estimated from the size of the JSON text, are in use.
+     */
+    class JsonCache {
+        struct Entry {
+            std::string key{};
+            CachedJson document{};
+            std::size_t cost{0};
+        };
+
+        std::mutex mutex{};
+        std::list<Entry> entries{}; // most recently used first
+        std::unordered_map<std::string, std::list<Entry>::iterator> index{};
+        std::size_t used{0};
+    public:
+        explicit JsonCache() = default;
+        ~JsonCache() = default;
+        JsonCache(const JsonCache&) = delete;
+        JsonCache& operator=(const JsonCache&) = delete;
+
+        [[nodiscard]] static std::string make_key(const std::string& table, const std::string& key, const std::string& value);
+
+        [[nodiscard]] CachedJson find(const std::string& key);
+        void insert(const std::string& key, const CachedJson& document, std::size_t size);
+        void erase(const std::string& key);
+
+        // the cached document if the row is unchanged, otherwise text is parsed and cached
+        [[nodiscard]] std::shared_ptr<const nlohmann::json> parse(const std::string& key, int64_t id, int64_t version, const std::string& text);
+    };
+
+    inline JsonCache json_cache{};
+} // namespace ff
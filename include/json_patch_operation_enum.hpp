@@ -0,0 +1,9 @@
+#pragma once
+
+namespace ff {
+    enum class JsonPatchOperation {
+        Set,
+        Append,
+        Remove,
+    };
+} // namespace ff
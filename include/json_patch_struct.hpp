@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include <json_patch_operation_enum.hpp>
+
+namespace ff {
+    struct JsonPatch {
+        JsonPatchOperation operation{JsonPatchOperation::Set};
+        std::vector<std::string> path{}; /* object keys from the root of the document; every key but the last must exist */
+        nlohmann::json value{}; /* unused for JsonPatchOperation::Remove */
+    };
+} // namespace ff
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include <database.hpp>
+
+namespace ff {
+    // what a listing filters on in the JSON of a row
+    struct ListingDocument {
+        bool listed{false}; // listings skip rows without a meta object
+        std::vector<std::string> categories{}; // lowercase
+        std::string filename{}; // lowercase, empty if unset
+    };
+
+    ListingDocument get_listing_document(const nlohmann::json& json);
+
+    /* The "filter" of /api/get_forwarders and /api/get_files, and the one definition of
+     * what it matches. The SQL path uses get_where() for the listing columns and
+     * matches() for what is only in the JSON. ff::Catalog::select() evaluates the same
+     * fields against its columns, and is_default_browse() decides when the catalog
+     * snapshot answers instead. Text fields compared case-insensitively are stored
+     * lowercase.
+     */
+    struct ListingFilter {
+        bool accepted{false}; // if true, must be accepted
+        bool needs_review{false}; // if true, must need review
+        std::string search_string{}; // if not empty, searched for in the full-text index
+        std::string identifier{}; // if not empty, must match this identifier exactly
+        std::string uploader{}; // if not empty, must match this uploader
+        std::string author{}; // if not empty, must match this author
+        std::string location{}; // forwarders only
+        std::string title_id{}; // forwarders only
+        std::string title{}; // sandbox only
+        std::string filename{}; // sandbox only; files without a filename always match
+        int type{-1}; // forwarders only; if not -1, must match this type (1 = channel, 0 = forwarder)
+        int vwii{-1}; // forwarders only; if not -1, must match this vwii (0 = no vwii, 1 = vwii)
+        bool has_submitted{false}; // if true, submitted must be between the two below
+        int64_t submitted_from{std::numeric_limits<int64_t>::min()};
+        int64_t submitted_to{std::numeric_limits<int64_t>::max()};
+        std::vector<std::string> categories{}; // if not empty, must be in one of these; matched as given against lowercase categories
+        int begin{-1}; // if more than 0, skip this many matches
+        int end{-1}; // if not -1, the index of the last match; turned into the page limit
+
+        /* The conditions on the listing columns, as " WHERE ..." or an empty string,
+         * with their parameters appended to parameters.
+         */
+        [[nodiscard]] std::string get_where(std::vector<DatabaseParameter>& parameters) const;
+        // the conditions get_where() leaves out: the categories and filename
+        [[nodiscard]] bool matches(const ListingDocument& document) const;
+        // whether this is what the browse page asks for: accepted uploads and nothing else
+        [[nodiscard]] bool is_default_browse() const;
+    };
+
+    // table is forwarders or sandbox; fields that do not apply to it are ignored
+    ListingFilter parse_listing_filter(const nlohmann::json& filter, const std::string& table);
+} // namespace ff
@@ -0,0 +1,11 @@
+#pragma once
+
+namespace ff {
+    enum class ListingSort {
+        Oldest,
+        Newest,
+        Downloads,
+        Rating,
+        Relevance,
+    };
+} // namespace ff
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <upload_stage_enum.hpp>
+#include <database_operation_enum.hpp>
+
+namespace ff {
+    // upper bounds in microseconds; the last bucket is +Inf
+    inline constexpr std::array<int64_t, 12> metrics_buckets{
+        1000, 5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000, 2500000, 5000000, 10000000,
+    };
+    inline constexpr std::array<int, 18> metrics_status_codes{
+        200, 201, 204, 206, 301, 302, 304, 400, 401, 403, 404, 405, 409, 413, 416, 429, 500, 503,
+    };
+    inline constexpr std::size_t metrics_max_routes{128};
+    inline constexpr std::size_t metrics_status_slots{metrics_status_codes.size() + 5}; // plus 1xx-5xx for the rest
+    inline constexpr std::size_t metrics_upload_stages{static_cast<std::size_t>(UploadStage::Thumbnail) + 1};
+
+    struct Histogram {
+        std::array<std::atomic<uint64_t>, metrics_buckets.size() + 1> buckets{};
+        std::atomic<uint64_t> sum{0}; // microseconds
+
+        void observe(int64_t duration);
+        void merge(const Histogram& histogram);
+        [[nodiscard]] uint64_t count() const;
+    };
+
+    /* Counters owned by a single thread. Only the owning thread writes to them, so
+     * recording is a relaxed load and store with no contention; the scraper reads
+     * them concurrently and sums every shard.
+     */
+    struct MetricsShard {
+        std::unique_ptr<std::atomic<Histogram*>[]> requests{}; // route * status slot, allocated on first use
+        std::array<Histogram, 2> database{}; // indexed by DatabaseOperation
+        std::array<Histogram, metrics_upload_stages> uploads{}; // indexed by UploadStage
+        std::atomic<uint64_t> asset_hits{0};
+        std::atomic<uint64_t> asset_misses{0};
+        std::atomic<uint64_t> asset_not_modified{0};
+        std::atomic<uint64_t> statement_hits{0};
+        std::atomic<uint64_t> statement_misses{0};
+        std::atomic<uint64_t> access_log_dropped{0};
+        std::atomic<int64_t> in_flight{0};
+
+        explicit MetricsShard();
+        ~MetricsShard();
+        MetricsShard(const MetricsShard&) = delete;
+        MetricsShard& operator=(const MetricsShard&) = delete;
+
+        Histogram& get_request(std::size_t route, std::size_t status_slot);
+        void merge(const MetricsShard& shard);
+    };
+
+    class Metrics {
+        std::mutex mutex{};
+        std::vector<std::string> routes{};
+        std::vector<MetricsShard*> shards{};
+        MetricsShard retired{}; // totals from threads that have exited
+
+        struct ShardHandle {
+            MetricsShard* shard{nullptr};
+            explicit ShardHandle();
+            ~ShardHandle();
+        };
+
+        MetricsShard& local();
+    public:
+        explicit Metrics() = default;
+        ~Metrics() = default;
+
+        [[nodiscard]] std::size_t register_route(std::string_view route);
+        void begin_request();
+        void end_request(std::size_t route, int http_status, int64_t duration);
+        void observe_database(DatabaseOperation operation, int64_t duration);
+        void observe_upload(UploadStage stage, int64_t duration);
+        void count_asset(bool hit);
+        void count_asset_not_modified();
+        void count_statement(bool hit);
+        void count_access_log_dropped();
+        [[nodiscard]] std::string render();
+    };
+
+    inline Metrics metrics{};
+
+    /* Times consecutive upload stages; next() closes the current stage and starts
+     * another, and the last one is recorded when the timer goes out of scope.
+     */
+    class UploadStageTimer {
+        UploadStage stage{};
+        std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+    public:
+        explicit UploadStageTimer(const UploadStage stage) : stage(stage) {}
+        ~UploadStageTimer() {
+            metrics.observe_upload(this->stage, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - this->start).count());
+        }
+        UploadStageTimer(const UploadStageTimer&) = delete;
+        UploadStageTimer& operator=(const UploadStageTimer&) = delete;
+
+        void next(const UploadStage next_stage) {
+            const auto now = std::chrono::steady_clock::now();
+            metrics.observe_upload(this->stage, std::chrono::duration_cast<std::chrono::microseconds>(now - this->start).count());
+            this->stage = next_stage;
+            this->start = now;
+        }
+    };
+} // namespace ff
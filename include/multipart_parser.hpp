@@ -0,0 +1,67 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+#include <unordered_map>
+#include <multipart_status_enum.hpp>
+#include <limhamn/http/http_server.hpp>
+
+namespace ff {
+    struct MultipartFile {
+        std::string name{};
+        std::string filename{};
+        std::string path{};
+        std::uintmax_t size{0};
+    };
+
+    struct MultipartLimits {
+        std::uintmax_t max_part_size{0}; // 0 means no limit
+        std::unordered_map<std::string, std::uintmax_t> part_limits{}; // overrides max_part_size by field name
+        std::size_t max_parts{64};
+    };
+
+    /* Incremental multipart/form-data parser. Bytes are fed as they arrive and every
+     * part is written straight to its own temporary file, so at most one boundary's
+     * worth of data is held in memory. Parsing stops at the first part that breaks
+     * the limits.
+     */
+    class MultipartParser {
+        enum class State {
+            Preamble,
+            Delimiter,
+            Headers,
+            Body,
+            Done,
+        };
+
+        std::string delimiter{};
+        MultipartLimits limits{};
+        State state{State::Preamble};
+        MultipartStatus status{MultipartStatus::Success};
+        std::string buffer{"\r\n"}; // the first boundary is not preceded by a line break
+        std::size_t position{0};
+        std::vector<MultipartFile> files{};
+        std::ofstream output{};
+        std::uintmax_t part_limit{0};
+
+        bool begin_part(const std::string& headers);
+        bool write(const char* data, std::size_t size);
+        MultipartStatus fail(MultipartStatus reason);
+    public:
+        MultipartParser(const std::string& boundary, MultipartLimits limits);
+        ~MultipartParser() = default;
+
+        MultipartStatus feed(std::string_view chunk);
+        MultipartStatus finish();
+        void discard();
+        [[nodiscard]] const std::vector<MultipartFile>& get_files() const;
+    };
+
+    std::string get_multipart_boundary(const limhamn::http::server::request& request);
+    std::pair<MultipartStatus, std::vector<MultipartFile>> parse_multipart_form(const limhamn::http::server::request& request, const MultipartLimits& limits);
+    // the JSON error response for a form parse_multipart_form() rejected
+    limhamn::http::server::response make_multipart_error_response(MultipartStatus status);
+} // namespace ff
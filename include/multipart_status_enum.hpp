@@ -0,0 +1,11 @@
+#pragma once
+
+namespace ff {
+    enum class MultipartStatus {
+        Success,
+        Malformed,
+        TooLarge,
+        TooManyParts,
+        WriteFailed,
+    };
+} // namespace ff
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include <database.hpp>
+#include <listing_sort_enum.hpp>
+
+namespace ff {
+    struct PageRequest {
+        ListingSort sort{ListingSort::Oldest};
+        std::size_t limit{0}; // 0 = the whole listing
+        bool has_cursor{false};
+        int64_t cursor_key{0}; // value of the sort column of the last row on the previous page
+        int64_t cursor_id{0}; // id of the last row on the previous page
+    };
+
+    /* Reads "sort", "cursor" and "limit" from a listing request. Only tables with
+     * downloads and rating columns and a search index are rankable. Throws
+     * std::invalid_argument if any of them is malformed.
+     */
+    PageRequest parse_page_request(const nlohmann::json& input, bool rankable);
+
+    /* Keyset pagination: selects the id, json and columns of the rows of from (a table,
+     * or a subquery aliased to one) matching where, in the requested order and after the
+     * cursor, and passes them to handle until it has accepted page.limit of them.
+     * Each query starts from the last row seen instead of an offset, so the cost of
+     * a page does not depend on how deep into the listing it is. Returns the cursor
+     * of the next page, or an empty string at the end.
+     */
+    std::string for_each_row_in_page(database& db, const std::string& from, const std::vector<std::string>& columns, const std::string& where,
+        const std::vector<DatabaseParameter>& parameters, const PageRequest& page,
+        const std::function<bool(const std::unordered_map<std::string, std::string>&)>& handle);
+
+    /* Selects the id and columns of the rows of table with the given ids, a batch of
+     * them per query, and passes them to handle in the order of ids. Ids without a
+     * row, such as rows deleted in the meantime, are skipped.
+     */
+    void for_each_row_by_id(database& db, const std::string& table, const std::vector<std::string>& columns, const std::vector<int64_t>& ids,
+        const std::function<void(const std::unordered_map<std::string, std::string>&)>& handle);
+} // namespace ff
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace ff {
+    struct Profile {
+        std::string display_name{};
+        std::string description{};
+        std::string profile_key{};
+    };
+
+    /* The public profiles of users, as /api/get_profile returns them. Pages ask
+     * for the same uploaders over and over, so they are kept for
+     * settings.profile_cache_ttl after being read; updating a profile invalidates
+     * its entry in this process, and the TTL bounds how long other worker
+     * processes show the old one.
+     */
+    class ProfileCache {
+        struct Entry {
+            Profile profile{};
+            std::chrono::steady_clock::time_point expires_at{};
+        };
+
+        std::mutex mutex{};
+        std::unordered_map<std::string, Entry> entries{};
+    public:
+        explicit ProfileCache() = default;
+        ~ProfileCache() = default;
+        ProfileCache(const ProfileCache&) = delete;
+        ProfileCache& operator=(const ProfileCache&) = delete;
+
+        [[nodiscard]] std::optional<Profile> find(const std::string& username);
+        void insert(const std::string& username, const Profile& profile);
+        void invalidate(const std::string& username);
+    };
+
+    inline ProfileCache profile_cache{};
+} // namespace ff
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <initializer_list>
+#include <database.hpp>
+#include <metrics.hpp>
+#include <limhamn/http/http_server.hpp>
+
+namespace ff {
+    using EndpointHandler = limhamn::http::server::response (*)(const limhamn::http::server::request&, database&);
+
+    struct Route {
+        std::string_view path{};
+        EndpointHandler handler{nullptr};
+        std::size_t metrics_id{0};
+    };
+
+    /* Route table built once at startup. Paths are views into string literals or
+     * static strings, so looking up an endpoint never allocates. Each route is
+     * registered with the metrics once here, and requests are recorded by its id.
+     */
+    class Router {
+        std::unordered_map<std::string_view, Route> exact{};
+        std::vector<Route> prefixes{};
+        Route fallback{};
+    public:
+        explicit Router(std::initializer_list<Route> exact_routes, std::initializer_list<Route> prefix_routes = {}, const EndpointHandler fallback = nullptr)
+            : prefixes(prefix_routes), fallback{"*", fallback, metrics.register_route("*")} {
+            this->exact.reserve(exact_routes.size());
+            for (const auto& it : exact_routes) {
+                this->exact.emplace(it.path, Route{it.path, it.handler, metrics.register_route(it.path)});
+            }
+            for (auto& it : this->prefixes) {
+                it.metrics_id = metrics.register_route(std::string{it.path} + "*");
+            }
+        }
+        ~Router() = default;
+
+        [[nodiscard]] const Route& find(const std::string_view endpoint) const {
+            if (const auto it = this->exact.find(endpoint); it != this->exact.end()) {
+                return it->second;
+            }
+
+            for (const auto& it : this->prefixes) {
+                if (endpoint.size() >= it.path.size() && endpoint.compare(0, it.path.size(), it.path) == 0) {
+                    return it;
+                }
+            }
+
+            return this->fallback;
+        }
+    };
+} // namespace ff
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <string>
+
+namespace ff {
+    /* Turns what a user typed into a full-text query that matches every word of it
+     * as a prefix: an FTS5 MATCH expression for SQLite, or a to_tsquery() string for
+     * PostgreSQL. Returns an empty string if there are no words to search for.
+     */
+    std::string make_search_query(const std::string& input, bool postgres);
+
+    /* A subquery selecting the rows of forwarders or sandbox that match a search
+     * query, along with their relevance as an integer "rank" column (higher is more
+     * relevant). It is aliased to the table name, so it can be used in place of the
+     * table, and takes the query from make_search_query() as its only parameter.
+     */
+    std::string get_search_source(const std::string& table, bool postgres);
+} // namespace ff
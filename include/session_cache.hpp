@@ -0,0 +1,60 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <user_type_enum.hpp>
+
+namespace ff {
+    struct CachedSession {
+        int64_t user_id{-1};
+        UserType user_type{UserType::Undefined};
+        bool activated{false};
+    };
+
+    /* Logins that were recently checked against the users table, so authenticated
+     * requests do not have to query it before doing their own work. Entries are
+     * keyed by username and hold the one key that is valid for that user, since
+     * logging in replaces it. The cache is split into shards with a mutex each, so
+     * request threads rarely wait on one another. Anything that changes a user's
+     * key, type or activation must call invalidate(). invalidate() only reaches
+     * this process, so with several workers the others keep trusting the old key
+     * and user type until the entry expires; settings.session_cache_ttl is that
+     * bound, and is kept short by default for this reason.
+     */
+    class SessionCache {
+        struct Entry {
+            std::string key{};
+            CachedSession session{};
+            std::chrono::steady_clock::time_point expires_at{};
+        };
+
+        struct Shard {
+            std::mutex mutex{};
+            std::unordered_map<std::string, Entry> entries{};
+            uint64_t generation{0}; // bumped by every invalidation
+        };
+
+        std::array<Shard, 16> shards{};
+
+        Shard& get_shard(const std::string& username);
+    public:
+        explicit SessionCache() = default;
+        ~SessionCache() = default;
+        SessionCache(const SessionCache&) = delete;
+        SessionCache& operator=(const SessionCache&) = delete;
+
+        [[nodiscard]] std::optional<CachedSession> find(const std::string& username, const std::string& key);
+        [[nodiscard]] std::optional<CachedSession> find(const std::string& username);
+        // read before querying the users table, and handed to insert() with the result
+        [[nodiscard]] uint64_t get_generation(const std::string& username);
+        void insert(const std::string& username, const std::string& key, const CachedSession& session, uint64_t generation);
+        void invalidate(const std::string& username);
+    };
+
+    inline SessionCache session_cache{};
+} // namespace ff
@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <string>
+#include <download_offload_enum.hpp>
 
 namespace ff {
     struct Settings {
@@ -92,6 +93,9 @@ namespace ff {
         bool log_warning_to_file{true};
         bool log_error_to_file{true};
         bool log_notice_to_file{true};
+        std::size_t access_log_buffer_size{8192};
+        std::size_t access_log_flush_size{64 * 1024};
+        int64_t access_log_flush_interval{1000};
         std::size_t password_min_length{8};
         std::size_t password_max_length{64};
         std::size_t username_min_length{3};
@@ -102,7 +106,15 @@ namespace ff {
         std::string title{"Forwarder Factory"};
         std::string description{"Forwarder Factory is a community dedicated to preserving and sharing Nintendo- and Wii-related content."};
         int default_user_type{0};
+        int64_t session_cache_ttl{5000};
+        std::size_t session_cache_size{65536};
+        int64_t profile_cache_ttl{60000};
+        std::size_t profile_cache_size{4096};
         bool preview_files{true};
+        DownloadOffload download_offload{DownloadOffload::None};
+        std::string download_offload_prefix{"/internal/data/"};
+        std::size_t download_log_buffer_size{65536};
+        int64_t download_log_flush_interval{1000};
         std::string email_username{};
         std::string email_password{};
         std::string email_from{};
@@ -114,13 +126,22 @@ namespace ff {
         std::string psql_host{"localhost"};
         int psql_port{5432};
         bool enabled_database{false};
+        std::size_t database_pool_size{0};
+        std::size_t database_statement_cache_size{64};
+        std::size_t json_cache_size{64 * 1024 * 1024};
+        int sqlite_busy_timeout{5000};
         bool trust_x_forwarded_for{false};
         int rate_limit{100};
+        std::size_t max_page_size{100};
+        std::size_t workers{1};
         std::vector<std::string> blacklisted_ips{};
         std::vector<std::string> whitelisted_ips{"127.0.0.1"};
+        bool enable_metrics{true};
+        bool restrict_metrics_to_whitelist{true};
         int64_t max_file_size_hash{1024 * 1024 * 1024};
-        bool cache_static{false};
-        bool cache_exists{false};
+        int64_t max_json_part_size{1024 * 1024};
+        int64_t max_image_part_size{16 * 1024 * 1024};
+        bool cache_static{true};
         bool convert_images_to_webp{true};
         bool convert_videos_to_webm{false};
         bool topics_require_admin{false};
@@ -0,0 +1,11 @@
+#pragma once
+
+namespace ff {
+    enum class UploadStage {
+        Multipart,
+        Wad,
+        Media,
+        Store,
+        Thumbnail,
+    };
+} // namespace ff
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <database.hpp>
+#include <limhamn/http/http_server.hpp>
+
+namespace ff {
+    /* Fixed number of threads that run endpoint handlers. Each worker owns one
+     * database connection for its whole lifetime, so handlers never share a
+     * connection and the number of connections is the size of the pool.
+     */
+    class WorkerPool {
+        using Task = std::function<void(database&)>;
+
+        std::vector<std::unique_ptr<database>> connections{};
+        std::vector<std::thread> threads{};
+        std::deque<Task> tasks{};
+        std::mutex mutex{};
+        std::condition_variable condition{};
+        bool stopping{false};
+
+        void run(database& db);
+    public:
+        explicit WorkerPool(std::vector<std::unique_ptr<database>> connections);
+        ~WorkerPool();
+        WorkerPool(const WorkerPool&) = delete;
+        WorkerPool& operator=(const WorkerPool&) = delete;
+
+        // runs the handler on a worker and blocks until it has returned
+        limhamn::http::server::response dispatch(const std::function<limhamn::http::server::response(database&)>& handler);
+        [[nodiscard]] std::size_t size() const;
+    };
+} // namespace ff
@@ -3139,6 +3139,37 @@ function post_comment_file(id, comment_str) {
         });
 }
 
+async function get_comments(type, id, cursor) {
+    const json = {
+        limit: 20,
+        cursor: cursor,
+    };
+    if (type === Forwarder) {
+        json.forwarder_identifier = id;
+    } else {
+        json.file_identifier = id;
+    }
+
+    try {
+        const response = await fetch('/api/get_comments', {
+            method: 'POST',
+            headers: {
+                'Content-Type': 'application/json',
+            },
+            body: JSON.stringify(json),
+        });
+
+        if (!response.ok) {
+            throw new Error(`Server error: ${response.status}`);
+        }
+
+        return await response.json();
+    } catch (error) {
+        console.error('Failed to get comments:', error);
+        return { comments: [], next_cursor: null };
+    }
+}
+
 function delete_comment_file(id, comment_id) {
     const json = {
         file_identifier: id,
@@ -3883,9 +3914,9 @@ async function draw_article(type, forwarder, id) {
     view_window.appendChild(post_comment);
     view_window.appendChild(document.createElement('br'));
 
-    const reviews = forwarder.reviews || [];
-    let index = 0;
-    const bsize = 20;
+    let cursor = null;
+    let has_more = true;
+    let loading = false;
 
     const comment_section = document.createElement('div');
     comment_section.className = 'view_floating_window_comment_section';
@@ -3893,10 +3924,16 @@ async function draw_article(type, forwarder, id) {
     view_window.appendChild(comment_section);
 
     async function draw_next() {
-        const next = reviews.slice(index, index + bsize);
-        index += bsize;
+        if (!has_more || loading) {
+            return;
+        }
+        loading = true;
+
+        const page = await get_comments(type, id, cursor);
+        cursor = page.next_cursor || null;
+        has_more = cursor !== null;
 
-        for (const [comment_id, review] of next.entries()) {
+        for (const review of page.comments) {
             const profile = await get_profile_for_user(review.username);
 
             const comment_div = document.createElement('div');
@@ -3931,9 +3968,9 @@ async function draw_article(type, forwarder, id) {
                 delete_button.innerHTML = '<i class="fa-solid fa-trash"></i>';
                 delete_button.onclick = () => {
                     if (type === Forwarder) {
-                        delete_comment_forwarder(id, comment_id);
+                        delete_comment_forwarder(id, review.id);
                     } else {
-                        delete_comment_file(id, comment_id);
+                        delete_comment_file(id, review.id);
                     }
                 };
                 comment_author.appendChild(delete_button);
@@ -3956,6 +3993,8 @@ async function draw_article(type, forwarder, id) {
 
             comment_section.appendChild(comment_div);
         }
+
+        loading = false;
     }
 
     draw_next();
@@ -0,0 +1,190 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <ff.hpp>
+#include <scrypto.hpp>
+#include <access_log.hpp>
+#include <metrics.hpp>
+
+namespace {
+    template <std::size_t N>
+    void copy_truncated(char (&dest)[N], const std::string& src) {
+        const std::size_t size = std::min(src.size(), N - 1);
+        std::memcpy(dest, src.data(), size);
+        dest[size] = '\0';
+    }
+
+    void format_record(std::string& out, const ff::AccessRecord& record) {
+        const auto seconds = static_cast<std::time_t>(record.timestamp / 1000);
+        std::tm tm{};
+        localtime_r(&seconds, &tm);
+
+        char time[32];
+        std::strftime(time, sizeof(time), "%Y-%m-%d %H:%M:%S", &tm);
+
+        char line[512];
+        const int size = std::snprintf(line, sizeof(line), "[%s] %s %s %s %d %.3fms\n",
+            time, record.ip_address, record.method, record.endpoint, record.http_status,
+            static_cast<double>(record.duration) / 1000.0);
+
+        if (size > 0) {
+            out.append(line, std::min(static_cast<std::size_t>(size), sizeof(line) - 1));
+        }
+    }
+}
+
+ff::AccessLog::~AccessLog() {
+    this->stop();
+}
+
+void ff::AccessLog::start() {
+    if (this->running.exchange(true)) {
+        return;
+    }
+
+    std::size_t capacity{1};
+    while (capacity < std::max<std::size_t>(settings.access_log_buffer_size, 2)) {
+        capacity <<= 1;
+    }
+
+    this->slots = std::make_unique<Slot[]>(capacity);
+    for (std::size_t i{0}; i < capacity; ++i) {
+        this->slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    this->mask = capacity - 1;
+    this->enqueue_position.store(0, std::memory_order_relaxed);
+    this->dequeue_position = 0;
+
+    this->writer = std::thread{&AccessLog::run, this};
+}
+
+void ff::AccessLog::stop() {
+    if (!this->running.exchange(false)) {
+        return;
+    }
+
+    if (this->writer.joinable()) {
+        this->writer.join();
+    }
+}
+
+void ff::AccessLog::push(const limhamn::http::server::request& request, const int http_status, const int64_t duration) {
+    if (!this->running.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    std::size_t position = this->enqueue_position.load(std::memory_order_relaxed);
+    Slot* slot{nullptr};
+
+    while (true) {
+        slot = &this->slots[position & this->mask];
+        const std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        const auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+
+        if (diff == 0) {
+            if (this->enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // the writer has not caught up
+            this->dropped.fetch_add(1, std::memory_order_relaxed);
+            metrics.count_access_log_dropped();
+            return;
+        } else {
+            position = this->enqueue_position.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->record.timestamp = scrypto::return_unix_millis();
+    slot->record.duration = duration;
+    slot->record.http_status = http_status;
+    copy_truncated(slot->record.ip_address, request.ip_address);
+    copy_truncated(slot->record.method, request.method);
+    copy_truncated(slot->record.endpoint, request.endpoint);
+
+    slot->sequence.store(position + 1, std::memory_order_release);
+}
+
+bool ff::AccessLog::pop(AccessRecord& record) {
+    Slot& slot = this->slots[this->dequeue_position & this->mask];
+    const std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+
+    if (sequence != this->dequeue_position + 1) {
+        return false;
+    }
+
+    record = slot.record;
+    slot.sequence.store(this->dequeue_position + this->mask + 1, std::memory_order_release);
+    ++this->dequeue_position;
+
+    return true;
+}
+
+void ff::AccessLog::run() {
+    std::FILE* file{nullptr};
+    if (settings.log_access_to_file) {
+        file = std::fopen(settings.access_file.c_str(), "a");
+        if (file == nullptr) {
+            logger.write_to_log(limhamn::logger::type::warning, "Failed to open the access log file " + settings.access_file + ".\n");
+        }
+    }
+
+    std::string batch{};
+    batch.reserve(settings.access_log_flush_size * 2);
+
+    const auto flush_interval = std::chrono::milliseconds{settings.access_log_flush_interval};
+    auto last_flush = std::chrono::steady_clock::now();
+
+    const auto flush = [&]() {
+        if (!batch.empty()) {
+            if (file != nullptr) {
+                std::fwrite(batch.data(), 1, batch.size(), file);
+                std::fflush(file);
+            }
+            if (settings.output_to_std) {
+                std::cout << batch << std::flush;
+            }
+            batch.clear();
+        }
+        last_flush = std::chrono::steady_clock::now();
+    };
+
+    while (true) {
+        const bool stopping = !this->running.load(std::memory_order_relaxed);
+
+        AccessRecord record{};
+        bool drained{true};
+        while (this->pop(record)) {
+            format_record(batch, record);
+            if (batch.size() >= settings.access_log_flush_size) {
+                drained = false;
+                break;
+            }
+        }
+
+        if (const auto dropped = this->dropped.exchange(0, std::memory_order_relaxed); dropped > 0) {
+            batch += "Dropped " + std::to_string(dropped) + " access log records; the buffer was full.\n";
+        }
+
+        if (batch.size() >= settings.access_log_flush_size || std::chrono::steady_clock::now() - last_flush >= flush_interval) {
+            flush();
+        }
+
+        if (stopping) {
+            while (this->pop(record)) {
+                format_record(batch, record);
+            }
+            flush();
+            break;
+        }
+
+        if (drained) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{10});
+        }
+    }
+
+    if (file != nullptr) {
+        std::fclose(file);
+    }
+}
@@ -1,5 +1,9 @@
 #include <scrypto.hpp>
 #include <ff.hpp>
+#include <session_cache.hpp>
+#include <profile_cache.hpp>
+#include <multipart_parser.hpp>
+#include <asset_bundle.hpp>
 #define LIMHAMN_SMTP_CLIENT_IMPL
 #include <limhamn/smtp/smtp_client.hpp>
 #include <nlohmann/json.hpp>
@@ -18,16 +22,62 @@ bool ff::ensure_admin_account_exists(database& database) {
     return false;
 }
 
-bool ff::verify_key(database& database, const std::string& username, const std::string& key) {
-    for (auto& it : database.query("SELECT * FROM users WHERE username = ? AND key = ?;", username, key)) {
-        if (it.empty()) {
-            return false;
+/* Each worker process has its own needs_setup, and setup finishes on only one of them,
+ * so while it is set the database decides. The process that first sees an administrator
+ * clears it and rebuilds the assets, which no longer start the setup page.
+ */
+bool ff::check_needs_setup(database& database) {
+    if (!needs_setup) {
+        return false;
+    }
+    if (!ensure_admin_account_exists(database)) {
+        return true;
+    }
+
+    if (needs_setup.exchange(false)) {
+        asset_bundle.load();
+    }
+    return false;
+}
+
+namespace {
+    // reads the user with that username and key from the users table, and caches it
+    std::optional<ff::CachedSession> load_session(ff::database& database, const std::string& username, const std::string& key) {
+        const uint64_t generation = ff::session_cache.get_generation(username);
+
+        for (const auto& it : database.query("SELECT id, user_type, email, json FROM users WHERE username = ? AND key = ?;", username, key)) {
+            ff::CachedSession session{};
+            session.user_id = std::stoll(it.at("id"));
+            if (it.at("user_type") == "0") {
+                session.user_type = ff::UserType::User;
+            } else if (it.at("user_type") == "1") {
+                session.user_type = ff::UserType::Administrator;
+            }
+
+            try {
+                const auto json = nlohmann::json::parse(it.at("json"));
+                session.activated = !it.at("email").empty() && json.contains("activated") && json.at("activated").is_boolean() && json.at("activated").get<bool>();
+            } catch (const std::exception&) {
+                session.activated = false;
+            }
+
+            ff::session_cache.insert(username, key, session, generation);
+            return session;
         }
 
+        return std::nullopt;
+    }
+}
+
+bool ff::verify_key(database& database, const std::string& username, const std::string& key) {
+    if (username.empty() || key.empty()) {
+        return false;
+    }
+    if (session_cache.find(username, key).has_value()) {
         return true;
     }
 
-    return false;
+    return load_session(database, username, key).has_value();
 }
 
 bool ff::ensure_valid_creds(database& database, const std::string& username, const std::string& password) {
@@ -51,6 +101,10 @@ bool ff::ensure_valid_creds(database& database, const std::string& username, con
 }
 
 int ff::get_user_id(database& database, const std::string& username) {
+    if (const auto session = session_cache.find(username)) {
+        return static_cast<int>(session->user_id);
+    }
+
     for (const auto& it : database.query("SELECT id FROM users WHERE username = ?;", username)) {
         if (it.empty()) {
             return -1;
@@ -63,6 +117,10 @@ int ff::get_user_id(database& database, const std::string& username) {
 }
 
 ff::UserType ff::get_user_type(database& database, const std::string& username) {
+    if (const auto session = session_cache.find(username)) {
+        return session->user_type;
+    }
+
     for (const auto& it : database.query("SELECT user_type FROM users WHERE username = ?;", username)) {
         if (it.empty()) {
             return ff::UserType::Undefined;
@@ -84,6 +142,9 @@ bool ff::user_is_verified(database& database, const std::string& username) {
     if (settings.enable_email_verification == false) {
         return true;
     }
+    if (const auto session = session_cache.find(username)) {
+        return session->activated;
+    }
 
     for (const auto& it : database.query("SELECT * FROM users WHERE username = ?;", username)) {
         if (it.empty()) {
@@ -195,6 +256,7 @@ std::pair<ff::LoginStatus, std::string> ff::try_login(database& database, const
         if (!database.exec("UPDATE users SET updated_at = ?, ip_address = ?, user_agent = ?, key = ? WHERE username = ?;", last_login, base_ip_address, base_user_agent, key, base_username)) {
             return {ff::LoginStatus::Failure, {}};
         }
+        session_cache.invalidate(base_username); // the previous key is no longer valid
 
         if (settings.enable_email_verification && !user_is_verified(database, base_username)) {
             return {ff::LoginStatus::Inactive, {}};
@@ -253,6 +315,7 @@ ff::AccountCreationStatus ff::make_account(database& database, const std::string
         if (!user_is_verified(database, base_username) && settings.enable_email_verification) {
             database.exec("DELETE FROM users WHERE username = ?;", base_username);
             database.exec("DELETE FROM activation_urls WHERE username = ?;", base_username);
+            session_cache.invalidate(base_username);
         }
     } catch (const std::exception&) {
         return ff::AccountCreationStatus::Failure;
@@ -369,7 +432,17 @@ ff::ProfileUpdateStatus ff::update_profile(const limhamn::http::server::request&
     logger.write_to_log(limhamn::logger::type::notice, "Attempting to upload a file.\n");
 #endif
 
-    const auto file_handles = limhamn::http::utils::parse_multipart_form_file(request.raw_body, settings.temp_directory + "/%f-%h-%r");
+    const auto [multipart_status, file_handles] = ff::parse_multipart_form(request, ff::MultipartLimits{
+        .max_part_size = static_cast<std::uintmax_t>(settings.max_image_part_size),
+        .part_limits = {
+            {"json", settings.max_json_part_size},
+        },
+        .max_parts = 2,
+    });
+    if (multipart_status != ff::MultipartStatus::Success) {
+        return ff::ProfileUpdateStatus::Failure;
+    }
+
     for (const auto& it : file_handles) {
 #ifdef FF_DEBUG
         logger.write_to_log(limhamn::logger::type::notice, "File name: " + it.filename + ", Name: " + it.name + "\n");
@@ -414,12 +487,7 @@ ff::ProfileUpdateStatus ff::update_profile(const limhamn::http::server::request&
         }
     }
 
-    nlohmann::json db_json;
-    try {
-        db_json = nlohmann::json::parse(ff::get_json_from_table(db, "users", "username", username));
-    } catch (const std::exception&) {
-        return ff::ProfileUpdateStatus::Failure;
-    }
+    nlohmann::json profile = nlohmann::json::object();
 
     if (!icon_path.empty()) {
         if (!ff::validate_image(icon_path)) {
@@ -442,19 +510,28 @@ ff::ProfileUpdateStatus ff::update_profile(const limhamn::http::server::request&
             return ff::ProfileUpdateStatus::Failure;
         }
 
-        db_json["profile"]["profile_key"] = icon_key;
+        profile["profile_key"] = icon_key;
     }
     if (user_json.find("display_name") != user_json.end() && user_json.at("display_name").is_string() &&
         !user_json.at("display_name").empty()) {
-        db_json["profile"]["display_name"] = limhamn::http::utils::htmlspecialchars(user_json.at("display_name").get<std::string>());
+        profile["display_name"] = limhamn::http::utils::htmlspecialchars(user_json.at("display_name").get<std::string>());
     } else {
-        db_json["profile"]["display_name"] = username; // fallback to username
+        profile["display_name"] = username; // fallback to username
     }
     if (user_json.find("description") != user_json.end() && user_json.at("description").is_string()) {
-        db_json["profile"]["description"] = limhamn::http::utils::htmlspecialchars(user_json.at("description").get<std::string>());
+        profile["description"] = limhamn::http::utils::htmlspecialchars(user_json.at("description").get<std::string>());
     }
 
-    ff::set_json_in_table(db, "users", "username", username, db_json.dump());
+    const bool updated = ff::update_json_in_table(db, "users", "username", username, [&profile](nlohmann::json& db_json) -> bool {
+        for (const auto& it : profile.items()) {
+            db_json["profile"][it.key()] = it.value();
+        }
+        return true;
+    });
+    if (!updated) {
+        return ff::ProfileUpdateStatus::Failure;
+    }
+    profile_cache.invalidate(username);
 
     return ff::ProfileUpdateStatus::Success;
 }
@@ -0,0 +1,251 @@
+#include <filesystem>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <ff.hpp>
+#include <scrypto.hpp>
+#include <asset_bundle.hpp>
+#include <metrics.hpp>
+#include <limhamn/http/http_utils.hpp>
+
+namespace {
+    std::time_t get_modification_time(const std::string& path) {
+        struct stat st{};
+        if (path.empty() || stat(path.c_str(), &st) != 0) {
+            return 0;
+        }
+        return st.st_mtime;
+    }
+
+    std::string render_html(const std::string& path) {
+        // get domain from site url
+        std::string domain = ff::settings.site_url;
+        if (domain.find("https://") != std::string::npos) {
+            domain = domain.substr(8);
+        } else if (domain.find("http://") != std::string::npos) {
+            domain = domain.substr(7);
+        }
+        if (domain.find('/') != std::string::npos) {
+            domain = domain.substr(0, domain.find('/'));
+        }
+        const std::vector<std::pair<std::string, std::string>> find_replace_table = {
+            {"{{ff_title}}", ff::settings.title},
+            {"{{ff_description}}", ff::settings.description},
+            {"{{ff_domain}}", domain},
+            {"{{ff_favicon_path}}", ff::virtual_favicon_path},
+            {"{{ff_css_path}}", ff::virtual_stylesheet_path},
+            {"{{ff_js_path}}", ff::virtual_script_path},
+            {"{{ff_body_replace}}", ff::needs_setup ? "<script>setup();</script>" : ""},
+            {"\n", ""},
+            {"\t", ""},
+        };
+
+        auto contents = ff::open_file(path);
+        for (const auto& it : find_replace_table) {
+            size_t pos = 0;
+            while ((pos = contents.find(it.first, pos)) != std::string::npos) {
+                contents.replace(pos, it.first.length(), it.second);
+                pos += it.second.length();
+            }
+        }
+
+        return contents;
+    }
+
+    // TODO: Just like the name, this function is UGLY AS FUCK, and does not belong anywhere near
+    // a project like this. But I simply cannot be bothered to write a JS minifier myself, nor
+    // am I aware of any C++ library for doing such a thing, and I am therefore just going to call uglifyjs.
+    std::string read_script(const std::string& path) {
+#ifndef FF_DEBUG
+        if (std::system("which uglifyjs > /dev/null") != 0) {
+            return ff::open_file(path);
+        }
+
+        // every worker loads the assets at the same time, so each needs a file of its own;
+        // the pid keeps them apart even if the workers were forked with the same random state
+        const std::string temp_file = ff::get_temp_path() + "-" + std::to_string(getpid()) + ".js";
+        std::filesystem::copy_file(path, temp_file);
+
+        // run uglifyjs on the file
+        std::string command = "uglifyjs " + temp_file + " -o " + temp_file;
+        if (std::system(command.c_str()) != 0) {
+            std::filesystem::remove(temp_file);
+            return ff::open_file(path);
+        }
+
+        auto contents = ff::open_file(temp_file);
+        std::filesystem::remove(temp_file);
+
+        return contents;
+#else
+        return ff::open_file(path);
+#endif
+    }
+}
+
+ff::Asset ff::make_asset(const std::string& source_file, std::string contents, const std::string& content_type, const std::string& cache_control,
+    const ff::CompressionLevel level) {
+    ff::Asset asset{};
+
+    const std::string hash = scrypto::sha256hash(contents);
+
+    asset.content_type = content_type;
+    asset.compressible = ff::is_compressible(content_type);
+
+    // each encoding is compressed once here and never again per request
+    if (asset.compressible && contents.size() > 256) {
+        const auto add_variant = [&](const ff::ContentEncoding encoding, std::string compressed) {
+            if (compressed.size() < contents.size()) {
+                asset.variants.at(static_cast<std::size_t>(encoding)) = ff::AssetVariant{
+                    .data = std::make_shared<const std::string>(std::move(compressed)),
+                    .etag = "\"" + hash + "-" + ff::get_encoding_name(encoding) + "\"",
+                };
+            }
+        };
+
+        add_variant(ff::ContentEncoding::Gzip, ff::gzip_compress(contents, level));
+#ifdef FF_ENABLE_BROTLI
+        add_variant(ff::ContentEncoding::Brotli, ff::brotli_compress(contents, level));
+#endif
+#ifdef FF_ENABLE_ZSTD
+        add_variant(ff::ContentEncoding::Zstd, ff::zstd_compress(contents, level));
+#endif
+    }
+
+    asset.variants.at(static_cast<std::size_t>(ff::ContentEncoding::Identity)) = ff::AssetVariant{
+        .data = std::make_shared<const std::string>(std::move(contents)),
+        .etag = "\"" + hash + "\"",
+    };
+    asset.cache_control = cache_control;
+    asset.source_file = source_file;
+    asset.modified_at = get_modification_time(source_file);
+    asset.last_modified = asset.modified_at ? ff::http_date(asset.modified_at) : "";
+
+    return asset;
+}
+
+void ff::AssetBundle::load() {
+    std::lock_guard<std::mutex> lock{this->load_mutex};
+
+    auto assets = std::make_shared<Assets>();
+
+    const auto exists = [](const std::string& path) -> bool {
+        return !path.empty() && std::filesystem::is_regular_file(path);
+    };
+
+    if (exists(settings.html_file)) {
+        assets->emplace("/", make_asset(settings.html_file, render_html(settings.html_file), "text/html", "no-cache"));
+    }
+
+    assets->emplace(virtual_stylesheet_path, make_asset(settings.css_file,
+        exists(settings.css_file) ? open_file(settings.css_file) : "", "text/css", "no-cache"));
+    assets->emplace(virtual_script_path, make_asset(settings.script_file,
+        exists(settings.script_file) ? read_script(settings.script_file) : "", "text/javascript", "no-cache"));
+    assets->emplace(virtual_favicon_path, make_asset(settings.favicon_file,
+        exists(settings.favicon_file) ? open_file(settings.favicon_file) : "", "image/svg+xml", "public, max-age=86400"));
+
+    for (const auto& it : settings.custom_paths) {
+        if (!exists(it.second)) {
+            logger.write_to_log(limhamn::logger::type::warning, "Custom path " + it.first + " points to " + it.second + ", which does not exist.\n");
+            continue;
+        }
+
+        (*assets)[it.first] = make_asset(it.second, open_file(it.second),
+            limhamn::http::utils::get_appropriate_content_type(it.first), "public, max-age=86400");
+    }
+
+    std::atomic_store(&this->assets, std::shared_ptr<const Assets>{std::move(assets)});
+}
+
+bool ff::AssetBundle::is_stale(const Asset& asset) const {
+    return !asset.source_file.empty() && get_modification_time(asset.source_file) != asset.modified_at;
+}
+
+std::shared_ptr<const ff::Asset> ff::AssetBundle::find(const std::string& path) {
+    auto assets = std::atomic_load(&this->assets);
+
+    auto it = assets->find(path);
+    if (it == assets->end()) {
+        return nullptr;
+    }
+
+    // when static files are not cached, pick up changes made on disk
+    if (!settings.cache_static && this->is_stale(it->second)) {
+        metrics.count_asset(false);
+        this->load();
+
+        assets = std::atomic_load(&this->assets);
+        it = assets->find(path);
+        if (it == assets->end()) {
+            return nullptr;
+        }
+    } else {
+        metrics.count_asset(true);
+    }
+
+    return {assets, &it->second};
+}
+
+limhamn::http::server::response ff::AssetBundle::serve(const limhamn::http::server::request& request, const Asset& asset) const {
+    limhamn::http::server::response response{};
+
+    ContentEncoding encoding{ContentEncoding::Identity};
+    if (asset.compressible) {
+        encoding = negotiate_encoding(get_header(request, "Accept-Encoding"));
+        if (asset.variants.at(static_cast<std::size_t>(encoding)).data == nullptr) {
+            encoding = ContentEncoding::Identity;
+        }
+
+        response.headers.push_back({"Vary", "Accept-Encoding"});
+    }
+
+    const auto& variant = asset.variants.at(static_cast<std::size_t>(encoding));
+
+    response.content_type = asset.content_type;
+    response.headers.push_back({"ETag", variant.etag});
+    response.headers.push_back({"Cache-Control", asset.cache_control});
+    if (!asset.last_modified.empty()) {
+        response.headers.push_back({"Last-Modified", asset.last_modified});
+    }
+
+    const auto if_none_match = get_header(request, "If-None-Match");
+    const auto not_modified = [&]() -> bool {
+        if (!if_none_match.empty()) {
+            return if_none_match.find(variant.etag) != std::string::npos || if_none_match == "*";
+        }
+
+        const auto if_modified_since = get_header(request, "If-Modified-Since");
+        return !if_modified_since.empty() && if_modified_since == asset.last_modified;
+    };
+
+    if (not_modified()) {
+        metrics.count_asset_not_modified();
+        response.http_status = 304;
+        return response;
+    }
+
+    if (encoding != ContentEncoding::Identity) {
+        response.headers.push_back({"Content-Encoding", get_encoding_name(encoding)});
+    }
+
+    response.http_status = 200;
+    // the response owns its body as a std::string, so every hit copies the buffer
+    response.body = *variant.data;
+
+    return response;
+}
+
+limhamn::http::server::response ff::AssetBundle::serve(const limhamn::http::server::request& request, const std::string& path) {
+    const auto asset = this->find(path);
+
+    if (asset == nullptr) {
+        limhamn::http::server::response response{};
+
+        response.content_type = "text/html";
+        response.http_status = 404;
+        response.body = "<p>404 Not Found</p>";
+
+        return response;
+    }
+
+    return this->serve(request, *asset);
+}
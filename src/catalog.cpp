@@ -0,0 +1,335 @@
+#include <algorithm>
+#include <ff.hpp>
+#include <catalog.hpp>
+
+namespace {
+    // NULL columns come back as empty strings
+    bool get_integer(const std::unordered_map<std::string, std::string>& row, const std::string& column, int64_t& value) {
+        const auto it = row.find(column);
+        if (it == row.end() || it->second.empty()) {
+            return false;
+        }
+
+        value = std::stoll(it->second);
+        return true;
+    }
+
+    std::string get_text(const std::unordered_map<std::string, std::string>& row, const std::string& column) {
+        const auto it = row.find(column);
+        return it == row.end() ? "" : it->second;
+    }
+}
+
+ff::Bitmap::Bitmap(const std::size_t size, const bool value) : words((size + 63) / 64, value ? ~uint64_t{0} : 0), size(size) {
+    if (value && size % 64 != 0) {
+        this->words.back() = (uint64_t{1} << (size % 64)) - 1;
+    }
+}
+
+void ff::Bitmap::set(const std::size_t row) {
+    this->words.at(row / 64) |= uint64_t{1} << (row % 64);
+}
+
+bool ff::Bitmap::test(const std::size_t row) const {
+    return row < this->size && (this->words[row / 64] >> (row % 64)) & 1;
+}
+
+ff::Bitmap& ff::Bitmap::operator&=(const Bitmap& other) {
+    for (std::size_t i{0}; i < this->words.size(); ++i) {
+        this->words[i] &= i < other.words.size() ? other.words[i] : 0;
+    }
+    return *this;
+}
+
+ff::Bitmap& ff::Bitmap::operator|=(const Bitmap& other) {
+    for (std::size_t i{0}; i < this->words.size() && i < other.words.size(); ++i) {
+        this->words[i] |= other.words[i];
+    }
+    return *this;
+}
+
+std::vector<uint32_t> ff::Bitmap::get_rows() const {
+    std::vector<uint32_t> rows{};
+    for (std::size_t i{0}; i < this->words.size(); ++i) {
+        for (uint64_t word = this->words[i]; word != 0; word &= word - 1) {
+            rows.push_back(static_cast<uint32_t>(i * 64 + __builtin_ctzll(word)));
+        }
+    }
+    return rows;
+}
+
+void ff::Catalog::Column::add(const std::string& value) {
+    if (value.empty()) {
+        this->rows.push_back(0);
+        return;
+    }
+
+    const auto it = this->values.try_emplace(value, static_cast<uint32_t>(this->values.size() + 1)).first;
+    this->rows.push_back(it->second);
+}
+
+ff::Bitmap ff::Catalog::Column::find(const std::string& value, const bool match_null) const {
+    Bitmap bitmap{this->rows.size()};
+
+    const auto it = this->values.find(value);
+    const uint32_t wanted = it == this->values.end() ? std::numeric_limits<uint32_t>::max() : it->second;
+
+    for (std::size_t i{0}; i < this->rows.size(); ++i) {
+        if (this->rows[i] == wanted || (match_null && this->rows[i] == 0)) {
+            bitmap.set(i);
+        }
+    }
+
+    return bitmap;
+}
+
+ff::Catalog::Catalog(std::string table) : table(std::move(table)) {}
+
+std::shared_ptr<const ff::Catalog::Data> ff::Catalog::build(database& db, const int64_t generation, const Data& previous) const {
+    auto data = std::make_shared<Data>();
+    data->generation = generation;
+
+    const bool forwarders = this->table == "forwarders";
+    const auto rows = db.query("SELECT id, identifier, version, needs_review, uploader, author, submitted, downloads, rating" +
+        std::string{forwarders ? ", type, location, title_id, vwii_compatible" : ", title"} + " FROM " + this->table + " ORDER BY id ASC;");
+
+    // only the JSON of new and changed rows is read
+    std::vector<int64_t> stale{};
+    for (const auto& it : rows) {
+        const int64_t id = std::stoll(it.at("id"));
+        const auto document = previous.documents.find(id);
+        if (document != previous.documents.end() && document->second.version == std::stoll(it.at("version"))) {
+            data->documents.emplace(id, document->second);
+        } else {
+            stale.push_back(id);
+        }
+    }
+
+    for_each_row_by_id(db, this->table, {"version", "json"}, stale, [&](const std::unordered_map<std::string, std::string>& it) -> void {
+        Document document{};
+        document.version = std::stoll(it.at("version"));
+
+        nlohmann::json json{};
+        try {
+            json = *ff::get_parsed_json_from_row(this->table, it);
+        } catch (const std::exception&) {
+            json = nullptr;
+        }
+
+        document.listing = get_listing_document(json);
+
+        data->documents.insert_or_assign(std::stoll(it.at("id")), std::move(document));
+    });
+
+    const std::size_t size = rows.size();
+    data->ids.reserve(size);
+    data->downloads.reserve(size);
+    data->rating.reserve(size);
+    data->listed = Bitmap{size};
+    data->reviewed = Bitmap{size};
+    data->needs_review = Bitmap{size};
+    data->forwarder = Bitmap{size};
+    data->channel = Bitmap{size};
+    data->vwii = Bitmap{size};
+    data->not_vwii = Bitmap{size};
+
+    for (std::size_t row{0}; row < size; ++row) {
+        const auto& it = rows[row];
+        const int64_t id = std::stoll(it.at("id"));
+
+        data->ids.push_back(id);
+        data->identifiers.emplace(it.at("identifier"), static_cast<uint32_t>(row));
+        data->uploader.add(get_text(it, "uploader"));
+        data->author.add(get_text(it, "author"));
+        data->location.add(get_text(it, "location"));
+        data->title_id.add(get_text(it, "title_id"));
+        data->title.add(get_text(it, "title"));
+
+        int64_t value{0};
+        data->downloads.push_back(get_integer(it, "downloads", value) ? value : 0);
+        data->rating.push_back(get_integer(it, "rating", value) ? value : 0);
+        if (get_integer(it, "needs_review", value)) {
+            value == 0 ? data->reviewed.set(row) : data->needs_review.set(row);
+        }
+        if (get_integer(it, "type", value) && (value == 0 || value == 1)) {
+            value == 0 ? data->forwarder.set(row) : data->channel.set(row);
+        }
+        if (get_integer(it, "vwii_compatible", value) && (value == 0 || value == 1)) {
+            value == 0 ? data->not_vwii.set(row) : data->vwii.set(row);
+        }
+        if (get_integer(it, "submitted", value)) {
+            data->submitted.emplace_back(value, static_cast<uint32_t>(row));
+        }
+
+        // a row deleted while the catalog was read has no document, and is not listed
+        const auto document = data->documents.find(id);
+        if (document == data->documents.end() || !document->second.listing.listed) {
+            data->filename.add("");
+            continue;
+        }
+
+        data->listed.set(row);
+        data->filename.add(document->second.listing.filename);
+        for (const auto& category : document->second.listing.categories) {
+            data->categories.try_emplace(category, size).first->second.set(row);
+        }
+    }
+
+    std::sort(data->submitted.begin(), data->submitted.end());
+
+    return data;
+}
+
+std::shared_ptr<const ff::Catalog::Data> ff::Catalog::get(database& db) {
+    // read before the rows, so a write made during a refresh is seen by the next one
+    const int64_t generation = get_catalog_generation(db, this->table);
+
+    auto data = std::atomic_load(&this->data);
+    if (data->generation >= generation) {
+        return data;
+    }
+
+    std::lock_guard<std::mutex> lock{this->refresh_mutex};
+
+    // another request may have refreshed it while this one waited
+    data = std::atomic_load(&this->data);
+    if (data->generation >= generation) {
+        return data;
+    }
+
+    data = this->build(db, generation, *data);
+    std::atomic_store(&this->data, data);
+
+    return data;
+}
+
+void ff::Catalog::refresh(database& db) {
+    static_cast<void>(this->get(db));
+}
+
+// must match what ff::ListingFilter::get_where() and matches() select
+ff::CatalogPage ff::Catalog::select(database& db, const ListingFilter& filter, const PageRequest& page) {
+    const auto data = this->get(db);
+    const std::size_t size = data->ids.size();
+
+    Bitmap matches = data->listed;
+
+    if (!filter.identifier.empty()) {
+        Bitmap bitmap{size};
+        if (const auto it = data->identifiers.find(filter.identifier); it != data->identifiers.end()) {
+            bitmap.set(it->second);
+        }
+        matches &= bitmap;
+    }
+    if (filter.accepted) {
+        matches &= data->reviewed;
+    }
+    if (filter.needs_review) {
+        matches &= data->needs_review;
+    }
+    if (!filter.uploader.empty()) {
+        matches &= data->uploader.find(filter.uploader);
+    }
+    if (!filter.author.empty()) {
+        matches &= data->author.find(filter.author);
+    }
+    if (!filter.location.empty()) {
+        matches &= data->location.find(filter.location);
+    }
+    if (!filter.title_id.empty()) {
+        matches &= data->title_id.find(filter.title_id);
+    }
+    if (!filter.title.empty()) {
+        matches &= data->title.find(filter.title);
+    }
+    if (!filter.filename.empty()) {
+        matches &= data->filename.find(filter.filename, true);
+    }
+    if (filter.type != -1) {
+        matches &= filter.type == 0 ? data->forwarder : data->channel;
+    }
+    if (filter.vwii != -1) {
+        matches &= filter.vwii == 0 ? data->not_vwii : data->vwii;
+    }
+    if (filter.has_submitted) {
+        Bitmap bitmap{size};
+        const auto begin = std::lower_bound(data->submitted.begin(), data->submitted.end(), std::make_pair(filter.submitted_from, uint32_t{0}));
+        for (auto it = begin; it != data->submitted.end() && it->first <= filter.submitted_to; ++it) {
+            bitmap.set(it->second);
+        }
+        matches &= bitmap;
+    }
+    if (!filter.categories.empty()) {
+        // categories are stored lowercase, and matched against the filter as it was given
+        Bitmap bitmap{size};
+        for (const auto& category : filter.categories) {
+            if (const auto it = data->categories.find(category); it != data->categories.end()) {
+                bitmap |= it->second;
+            }
+        }
+        matches &= bitmap;
+    }
+
+    // the same order and cursors as ff::for_each_row_in_page()
+    std::vector<uint32_t> rows = matches.get_rows();
+    const auto get_key = [&](const uint32_t row) -> int64_t {
+        switch (page.sort) {
+            case ListingSort::Downloads:
+                return data->downloads[row];
+            case ListingSort::Rating:
+                return data->rating[row];
+            default:
+                return data->ids[row];
+        }
+    };
+
+    const bool ascending = page.sort == ListingSort::Oldest;
+    if (!ascending) {
+        // rows are in ascending id order already
+        std::sort(rows.begin(), rows.end(), [&](const uint32_t a, const uint32_t b) {
+            return get_key(a) != get_key(b) ? get_key(a) > get_key(b) : data->ids[a] > data->ids[b];
+        });
+    }
+
+    std::size_t position{0};
+    if (page.has_cursor) {
+        const auto after_cursor = [&](const uint32_t row) -> bool {
+            const int64_t key = get_key(row);
+            const int64_t id = data->ids[row];
+            if (ascending) {
+                return id > page.cursor_id;
+            }
+            if (page.sort == ListingSort::Downloads || page.sort == ListingSort::Rating) {
+                return key < page.cursor_key || (key == page.cursor_key && id < page.cursor_id);
+            }
+            return id < page.cursor_id;
+        };
+        while (position < rows.size() && !after_cursor(rows[position])) {
+            ++position;
+        }
+    }
+    if (filter.begin > 0) {
+        position = std::min(rows.size(), position + static_cast<std::size_t>(filter.begin));
+    }
+
+    CatalogPage ret{};
+    const std::size_t end = page.limit == 0 ? rows.size() : std::min(rows.size(), position + page.limit);
+    for (std::size_t i{position}; i < end; ++i) {
+        ret.ids.push_back(data->ids[rows[i]]);
+    }
+
+    if (end < rows.size() && end > position) {
+        const uint32_t last = rows[end - 1];
+        ret.next_cursor = std::to_string(get_key(last)) + ":" + std::to_string(data->ids[last]);
+    }
+
+    return ret;
+}
+
+void ff::Catalog::for_each_row(database& db, const CatalogPage& page, const std::vector<std::string>& columns,
+    const std::function<void(const std::unordered_map<std::string, std::string>&)>& handle) const {
+    std::vector<std::string> selected{"version", "json"};
+    selected.insert(selected.end(), columns.begin(), columns.end());
+
+    for_each_row_by_id(db, this->table, selected, page.ids, handle);
+}
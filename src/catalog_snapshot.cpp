@@ -0,0 +1,111 @@
+#include <ff.hpp>
+#include <catalog_snapshot.hpp>
+#include <listing_filter.hpp>
+#include <pagination.hpp>
+
+std::shared_ptr<const ff::CatalogSnapshot::Snapshot> ff::CatalogSnapshot::build(database& db, const int64_t generation, const Snapshot& previous) {
+    auto snapshot = std::make_shared<Snapshot>();
+    snapshot->generation = generation;
+
+    // the rows the default browse filter selects by its columns; matches() is applied to their JSON below
+    const ListingFilter filter{.accepted = true};
+    std::vector<DatabaseParameter> parameters{};
+    const std::string where = filter.get_where(parameters);
+    const auto rows = db.query("SELECT id, version, rating_sum, rating_count, comment_count FROM forwarders" + where + " ORDER BY id ASC;", parameters);
+
+    std::vector<int64_t> stale{};
+    snapshot->order.reserve(rows.size());
+
+    for (const auto& it : rows) {
+        const int64_t id = std::stoll(it.at("id"));
+        snapshot->order.push_back(id);
+
+        const auto entry = previous.entries.find(id);
+        if (entry != previous.entries.end() &&
+            entry->second.version == std::stoll(it.at("version")) &&
+            entry->second.rating_sum == std::stoll(it.at("rating_sum")) &&
+            entry->second.rating_count == std::stoll(it.at("rating_count")) &&
+            entry->second.comment_count == std::stoll(it.at("comment_count"))) {
+            snapshot->entries.emplace(id, entry->second);
+        } else {
+            stale.push_back(id);
+        }
+    }
+
+    // nothing listed changed, e.g. the generation moved for counted downloads, so the body would come out the same
+    if (stale.empty() && snapshot->order == previous.order && previous.asset != nullptr) {
+        snapshot->asset = previous.asset;
+        return snapshot;
+    }
+
+    for_each_row_by_id(db, "forwarders", {"version", "rating_sum", "rating_count", "comment_count", "json"}, stale, [&](const std::unordered_map<std::string, std::string>& it) -> void {
+        Entry entry{
+            .version = std::stoll(it.at("version")),
+            .rating_sum = std::stoll(it.at("rating_sum")),
+            .rating_count = std::stoll(it.at("rating_count")),
+            .comment_count = std::stoll(it.at("comment_count")),
+        };
+
+        // the same as handle_api_get_forwarders_endpoint() makes of the row
+        nlohmann::json json{};
+        try {
+            json = *ff::get_parsed_json_from_row("forwarders", it);
+        } catch (const std::exception&) {
+            json = nullptr;
+        }
+        if (filter.matches(get_listing_document(json))) {
+            json["average_rating"] = entry.rating_count > 0 ? entry.rating_sum / entry.rating_count : 0;
+            json["rating_count"] = entry.rating_count;
+            json["ratings"] = nlohmann::json::object();
+            json["comment_count"] = entry.comment_count;
+            entry.json = std::make_shared<const std::string>(json.dump());
+        }
+
+        snapshot->entries.insert_or_assign(std::stoll(it.at("id")), std::move(entry));
+    });
+
+    // the entries are already serialized, so the body is put together around them
+    std::string body{"{\"forwarders\":["};
+    bool first{true};
+    for (const auto& id : snapshot->order) {
+        const auto entry = snapshot->entries.find(id);
+        if (entry == snapshot->entries.end() || entry->second.json == nullptr) {
+            continue;
+        }
+
+        if (!first) {
+            body += ',';
+        }
+        body += *entry->second.json;
+        first = false;
+    }
+    body += "],\"next_cursor\":null}";
+
+    // rebuilt while serving requests, so it is compressed for speed rather than size
+    snapshot->asset = std::make_shared<const Asset>(make_asset("", std::move(body), "application/json", "no-cache", CompressionLevel::Fast));
+
+    return snapshot;
+}
+
+std::shared_ptr<const ff::Asset> ff::CatalogSnapshot::get(database& db) {
+    // read before the rows, so a write made during a build is seen by the next request
+    const int64_t generation = get_catalog_generation(db, "forwarders");
+
+    auto snapshot = std::atomic_load(&this->snapshot);
+    if (snapshot->generation >= generation) {
+        return snapshot->asset;
+    }
+
+    std::lock_guard<std::mutex> lock{this->build_mutex};
+
+    // another request may have rebuilt it while this one waited
+    snapshot = std::atomic_load(&this->snapshot);
+    if (snapshot->generation >= generation) {
+        return snapshot->asset;
+    }
+
+    snapshot = build(db, generation, *snapshot);
+    std::atomic_store(&this->snapshot, snapshot);
+
+    return snapshot->asset;
+}
@@ -0,0 +1,146 @@
+#include <stdexcept>
+#include <vector>
+#include <algorithm>
+#include <zlib.h>
+#ifdef FF_ENABLE_BROTLI
+#include <brotli/encode.h>
+#endif
+#ifdef FF_ENABLE_ZSTD
+#include <zstd.h>
+#endif
+#include <compression.hpp>
+
+std::string ff::gzip_compress(const std::string& data, const CompressionLevel level) {
+    z_stream stream{};
+
+    // 15 + 16 makes zlib write a gzip header instead of a zlib one
+    if (deflateInit2(&stream, level == CompressionLevel::Best ? Z_BEST_COMPRESSION : Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 9, Z_DEFAULT_STRATEGY) != Z_OK) {
+        throw std::runtime_error{"Failed to initialize zlib."};
+    }
+
+    std::string ret{};
+    ret.resize(deflateBound(&stream, static_cast<uLong>(data.size())));
+
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef*>(ret.data());
+    stream.avail_out = static_cast<uInt>(ret.size());
+
+    const int status = deflate(&stream, Z_FINISH);
+    deflateEnd(&stream);
+
+    if (status != Z_STREAM_END) {
+        throw std::runtime_error{"Failed to gzip data."};
+    }
+
+    ret.resize(stream.total_out);
+    return ret;
+}
+
+#ifdef FF_ENABLE_BROTLI
+std::string ff::brotli_compress(const std::string& data, const CompressionLevel level) {
+    std::string ret{};
+    std::size_t size = BrotliEncoderMaxCompressedSize(data.size());
+    ret.resize(size);
+
+    // quality 5 is about as fast as gzip at a better ratio; 11 is many times slower
+    if (BrotliEncoderCompress(level == CompressionLevel::Best ? BROTLI_MAX_QUALITY : 5, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT,
+            data.size(), reinterpret_cast<const uint8_t*>(data.data()), &size, reinterpret_cast<uint8_t*>(ret.data())) != BROTLI_TRUE) {
+        throw std::runtime_error{"Failed to brotli compress data."};
+    }
+
+    ret.resize(size);
+    return ret;
+}
+#endif
+
+#ifdef FF_ENABLE_ZSTD
+std::string ff::zstd_compress(const std::string& data, const CompressionLevel level) {
+    std::string ret{};
+    ret.resize(ZSTD_compressBound(data.size()));
+
+    const std::size_t size = ZSTD_compress(ret.data(), ret.size(), data.data(), data.size(), level == CompressionLevel::Best ? 19 : 3);
+    if (ZSTD_isError(size)) {
+        throw std::runtime_error{"Failed to zstd compress data."};
+    }
+
+    ret.resize(size);
+    return ret;
+}
+#endif
+
+bool ff::is_compressible(const std::string& content_type) {
+    return content_type.find("text/") == 0 ||
+        content_type.find("javascript") != std::string::npos ||
+        content_type.find("json") != std::string::npos ||
+        content_type.find("xml") != std::string::npos;
+}
+
+ff::ContentEncoding ff::negotiate_encoding(const std::string& accept_encoding) {
+    if (accept_encoding.empty()) {
+        return ContentEncoding::Identity;
+    }
+
+    // ties are broken by this order, best compression ratio first
+    const std::vector<std::pair<std::string, ContentEncoding>> supported{
+#ifdef FF_ENABLE_BROTLI
+        {"br", ContentEncoding::Brotli},
+#endif
+#ifdef FF_ENABLE_ZSTD
+        {"zstd", ContentEncoding::Zstd},
+#endif
+        {"gzip", ContentEncoding::Gzip},
+    };
+
+    ContentEncoding best{ContentEncoding::Identity};
+    double best_q{0.0};
+
+    for (const auto& [name, encoding] : supported) {
+        std::size_t pos = 0;
+        while (pos < accept_encoding.size()) {
+            std::size_t end = accept_encoding.find(',', pos);
+            if (end == std::string::npos) {
+                end = accept_encoding.size();
+            }
+
+            std::string token = accept_encoding.substr(pos, end - pos);
+            pos = end + 1;
+
+            double q{1.0};
+            if (const auto semicolon = token.find(';'); semicolon != std::string::npos) {
+                const auto q_pos = token.find("q=", semicolon);
+                if (q_pos != std::string::npos) {
+                    try {
+                        q = std::stod(token.substr(q_pos + 2));
+                    } catch (const std::exception&) {
+                        q = 0.0;
+                    }
+                }
+                token.erase(semicolon);
+            }
+
+            token.erase(std::remove_if(token.begin(), token.end(), ::isspace), token.end());
+            std::transform(token.begin(), token.end(), token.begin(), ::tolower);
+
+            if (token == name && q > best_q) {
+                best = encoding;
+                best_q = q;
+            }
+        }
+    }
+
+    return best;
+}
+
+std::string ff::get_encoding_name(const ContentEncoding encoding) {
+    switch (encoding) {
+        case ContentEncoding::Gzip:
+            return "gzip";
+        case ContentEncoding::Brotli:
+            return "br";
+        case ContentEncoding::Zstd:
+            return "zstd";
+        default:
+            return "identity";
+    }
+}
@@ -41,6 +41,9 @@ ff::Settings ff::load_settings(const std::string& _config_file) {
         if (config["logger"]["log_warning_to_file"]) settings.log_warning_to_file = config["logger"]["log_warning_to_file"].as<bool>();
         if (config["logger"]["log_error_to_file"]) settings.log_error_to_file = config["logger"]["log_error_to_file"].as<bool>();
         if (config["logger"]["log_notice_to_file"]) settings.log_notice_to_file = config["logger"]["log_notice_to_file"].as<bool>();
+        if (config["logger"]["access_log_buffer_size"]) settings.access_log_buffer_size = config["logger"]["access_log_buffer_size"].as<std::size_t>();
+        if (config["logger"]["access_log_flush_size"]) settings.access_log_flush_size = config["logger"]["access_log_flush_size"].as<std::size_t>();
+        if (config["logger"]["access_log_flush_interval"]) settings.access_log_flush_interval = config["logger"]["access_log_flush_interval"].as<int64_t>();
         if (config["account"]["username_min_length"]) settings.username_min_length = config["account"]["username_min_length"].as<std::size_t>();
         if (config["account"]["username_max_length"]) settings.username_max_length = config["account"]["username_max_length"].as<std::size_t>();
         if (config["account"]["password_min_length"]) settings.password_min_length = config["account"]["password_min_length"].as<std::size_t>();
@@ -50,6 +53,10 @@ ff::Settings ff::load_settings(const std::string& _config_file) {
         if (config["account"]["allow_public_registration"]) settings.public_registration = config["account"]["allow_public_registration"].as<bool>();
         if (config["account"]["default_user_type"]) settings.default_user_type = config["account"]["default_user_type"].as<int>();
         if (config["account"]["enable_email_verification"]) settings.enable_email_verification = config["account"]["enable_email_verification"].as<bool>();
+        if (config["account"]["session_cache_ttl"]) settings.session_cache_ttl = config["account"]["session_cache_ttl"].as<int64_t>();
+        if (config["account"]["session_cache_size"]) settings.session_cache_size = config["account"]["session_cache_size"].as<std::size_t>();
+        if (config["account"]["profile_cache_ttl"]) settings.profile_cache_ttl = config["account"]["profile_cache_ttl"].as<int64_t>();
+        if (config["account"]["profile_cache_size"]) settings.profile_cache_size = config["account"]["profile_cache_size"].as<std::size_t>();
         if (config["filesystem"]["session_directory"]) settings.session_directory = config["filesystem"]["session_directory"].as<std::string>();
         if (config["filesystem"]["data_directory"]) settings.data_directory = config["filesystem"]["data_directory"].as<std::string>();
         if (config["filesystem"]["temp_directory"]) settings.temp_directory = config["filesystem"]["temp_directory"].as<std::string>();
@@ -62,9 +69,12 @@ ff::Settings ff::load_settings(const std::string& _config_file) {
         if (config["filesystem"]["error_file"]) settings.error_file = config["filesystem"]["error_file"].as<std::string>();
         if (config["filesystem"]["notice_file"]) settings.notice_file = config["filesystem"]["notice_file"].as<std::string>();
         if (config["filesystem"]["cache_static"]) settings.cache_static = config["filesystem"]["cache_static"].as<bool>();
-        if (config["filesystem"]["cache_exists"]) settings.cache_exists = config["filesystem"]["cache_exists"].as<bool>();
         if (config["database"]["type"]) settings.enabled_database = config["database"]["type"].as<std::string>() == "postgresql";
+        if (config["database"]["pool_size"]) settings.database_pool_size = config["database"]["pool_size"].as<std::size_t>();
+        if (config["database"]["statement_cache_size"]) settings.database_statement_cache_size = config["database"]["statement_cache_size"].as<std::size_t>();
+        if (config["database"]["json_cache_size"]) settings.json_cache_size = config["database"]["json_cache_size"].as<std::size_t>();
         if (config["sqlite3"]["sqlite_database_file"]) settings.sqlite_database_file = config["sqlite3"]["sqlite_database_file"].as<std::string>();
+        if (config["sqlite3"]["busy_timeout"]) settings.sqlite_busy_timeout = config["sqlite3"]["busy_timeout"].as<int>();
         if (config["postgresql"]["database"]) settings.psql_database = config["postgresql"]["database"].as<std::string>();
         if (config["postgresql"]["username"]) settings.psql_username = config["postgresql"]["username"].as<std::string>();
         if (config["postgresql"]["password"]) settings.psql_password = config["postgresql"]["password"].as<std::string>();
@@ -76,9 +86,24 @@ ff::Settings ff::load_settings(const std::string& _config_file) {
         if (config["site"]["description"]) settings.description = config["site"]["description"].as<std::string>();
         if (config["upload"]["max_request_size"]) settings.max_request_size = config["upload"]["max_request_size"].as<int64_t>();
         if (config["upload"]["max_file_size_hash"]) settings.max_file_size_hash = config["upload"]["max_file_size_hash"].as<int64_t>();
+        if (config["upload"]["max_json_part_size"]) settings.max_json_part_size = config["upload"]["max_json_part_size"].as<int64_t>();
+        if (config["upload"]["max_image_part_size"]) settings.max_image_part_size = config["upload"]["max_image_part_size"].as<int64_t>();
         if (config["upload"]["convert_images_to_webp"]) settings.convert_images_to_webp = config["upload"]["convert_images_to_webp"].as<bool>();
         if (config["upload"]["convert_videos_to_webm"]) settings.convert_videos_to_webm = config["upload"]["convert_videos_to_webm"].as<bool>();
         if (config["download"]["preview_files"]) settings.preview_files = config["download"]["preview_files"].as<bool>();
+        if (config["download"]["offload"]) {
+            const auto offload = config["download"]["offload"].as<std::string>();
+            if (offload == "x-accel-redirect") {
+                settings.download_offload = DownloadOffload::XAccelRedirect;
+            } else if (offload == "x-sendfile") {
+                settings.download_offload = DownloadOffload::XSendfile;
+            } else {
+                settings.download_offload = DownloadOffload::None;
+            }
+        }
+        if (config["download"]["offload_prefix"]) settings.download_offload_prefix = config["download"]["offload_prefix"].as<std::string>();
+        if (config["download"]["event_buffer_size"]) settings.download_log_buffer_size = config["download"]["event_buffer_size"].as<std::size_t>();
+        if (config["download"]["event_flush_interval"]) settings.download_log_flush_interval = config["download"]["event_flush_interval"].as<int64_t>();
     	if (config["topic"]["topics_require_admin"]) settings.topics_require_admin = config["topic"]["topics_require_admin"].as<bool>();
         if (config["smtp"]["server"]) settings.smtp_server = config["smtp"]["server"].as<std::string>();
         if (config["smtp"]["port"]) settings.smtp_port = config["smtp"]["port"].as<int>();
@@ -88,6 +113,10 @@ ff::Settings ff::load_settings(const std::string& _config_file) {
         if (config["http"]["port"]) settings.port = config["http"]["port"].as<int>();
         if (config["http"]["trust_x_forwarded_for"]) settings.trust_x_forwarded_for = config["http"]["trust_x_forwarded_for"].as<bool>();
         if (config["http"]["max_requests_per_ip_per_minute"]) settings.rate_limit = config["http"]["max_requests_per_ip_per_minute"].as<int>();
+        if (config["http"]["max_page_size"]) settings.max_page_size = config["http"]["max_page_size"].as<std::size_t>();
+        if (config["http"]["workers"]) settings.workers = config["http"]["workers"].as<std::size_t>();
+        if (config["http"]["enable_metrics"]) settings.enable_metrics = config["http"]["enable_metrics"].as<bool>();
+        if (config["http"]["restrict_metrics_to_whitelist"]) settings.restrict_metrics_to_whitelist = config["http"]["restrict_metrics_to_whitelist"].as<bool>();
         if (config["http"]["whitelisted_ips"]) {
             for (const auto& ip : config["http"]["whitelisted_ips"]) {
                 settings.whitelisted_ips.emplace_back(ip.as<std::string>());
@@ -141,6 +170,9 @@ std::string ff::generate_default_config() {
     ss << "#   log_warning_to_file: Whether to log warning messages to a file.\n";
     ss << "#   log_error_to_file: Whether to log error messages to a file.\n";
     ss << "#   log_notice_to_file: Whether to log notice messages to a file.\n";
+    ss << "#   access_log_buffer_size: The number of access log records that can be queued before new ones are dropped.\n";
+    ss << "#   access_log_flush_size: The number of bytes of access log lines to collect before writing them out.\n";
+    ss << "#   access_log_flush_interval: The longest time in milliseconds access log lines are held before being written out.\n";
     ss << "logger:\n";
     ss << "  output_to_std: " << (ff::settings.output_to_std ? "true" : "false") << "\n";
     ss << "  halt_on_error: " << (ff::settings.halt_on_error ? "true" : "false") << "\n";
@@ -148,6 +180,9 @@ std::string ff::generate_default_config() {
     ss << "  log_warning_to_file: " << (ff::settings.log_warning_to_file ? "true" : "false") << "\n";
     ss << "  log_error_to_file: " << (ff::settings.log_error_to_file ? "true" : "false") << "\n";
     ss << "  log_notice_to_file: " << (ff::settings.log_notice_to_file ? "true" : "false") << "\n";
+    ss << "  access_log_buffer_size: " << ff::settings.access_log_buffer_size << "\n";
+    ss << "  access_log_flush_size: " << ff::settings.access_log_flush_size << "\n";
+    ss << "  access_log_flush_interval: " << ff::settings.access_log_flush_interval << "\n";
     ss << "\n";
     ss << "# Account options:\n";
     ss << "#   username_min_length: The minimum length of a username.\n";
@@ -159,6 +194,12 @@ std::string ff::generate_default_config() {
     ss << "#   allow_public_registration: Whether to allow public registration.\n";
     ss << "#   default_user_type: The default user type. (0 = User, 1 = Administrator)\n";
     ss << "#   enable_email_verification: Whether to enable email verification. Requires a valid, set up SMTP server.\n";
+    ss << "#   session_cache_ttl: How long, in milliseconds, a verified login is trusted before the database is asked again. 0 disables the cache.\n";
+    ss << "#     Logging out, a password change or a role change is only seen at once by the worker that handled it; with workers > 1, the\n";
+    ss << "#     others may keep accepting the old key and role for up to this long.\n";
+    ss << "#   session_cache_size: The most logins each worker keeps cached.\n";
+    ss << "#   profile_cache_ttl: How long, in milliseconds, a public profile is cached before it is read again. 0 disables the cache.\n";
+    ss << "#   profile_cache_size: The most public profiles each worker keeps cached.\n";
     ss << "account:\n";
     ss << "  username_min_length: " << ff::settings.username_min_length << "\n";
     ss << "  username_max_length: " << ff::settings.username_max_length << "\n";
@@ -169,6 +210,10 @@ std::string ff::generate_default_config() {
     ss << "  allow_public_registration: " << (ff::settings.public_registration ? "true" : "false") << "\n";
     ss << "  default_user_type: " << ff::settings.default_user_type << "\n";
     ss << "  enable_email_verification: " << (ff::settings.enable_email_verification ? "true" : "false") << "\n";
+    ss << "  session_cache_ttl: " << ff::settings.session_cache_ttl << "\n";
+    ss << "  session_cache_size: " << ff::settings.session_cache_size << "\n";
+    ss << "  profile_cache_ttl: " << ff::settings.profile_cache_ttl << "\n";
+    ss << "  profile_cache_size: " << ff::settings.profile_cache_size << "\n";
     ss << "\n";
     ss << "# SMTP options:\n";
     ss << "#   server: The SMTP server.\n";
@@ -187,12 +232,20 @@ std::string ff::generate_default_config() {
     ss << "#   port: The port to run the web server on.\n";
     ss << "#   trust_x_forwarded_for: Whether to trust the X-Forwarded-For header. ONLY ENABLE IF YOU'RE USING A REVERSE PROXY THAT YOU TRUST!\n";
     ss << "#   max_requests_per_ip_per_minute: The maximum number of requests per IP per minute.\n";
+    ss << "#   max_page_size: The most items a listing endpoint returns per page when paginating.\n";
+    ss << "#   workers: The number of worker processes. With more than one, worker N listens on port + N.\n";
     ss << "#   whitelisted_ips: A list of whitelisted IPs.\n";
     ss << "#   blacklisted_ips: A list of blacklisted IPs.\n";
+    ss << "#   enable_metrics: Whether to expose Prometheus metrics at /metrics.\n";
+    ss << "#   restrict_metrics_to_whitelist: Whether only whitelisted IPs may read /metrics.\n";
     ss << "http:\n";
     ss << "  port: " << ff::settings.port << "\n";
     ss << "  trust_x_forwarded_for: " << (ff::settings.trust_x_forwarded_for ? "true" : "false") << "\n";
     ss << "  max_requests_per_ip_per_minute: " << ff::settings.rate_limit << "\n";
+    ss << "  max_page_size: " << ff::settings.max_page_size << "\n";
+    ss << "  workers: " << ff::settings.workers << "\n";
+    ss << "  enable_metrics: " << (ff::settings.enable_metrics ? "true" : "false") << "\n";
+    ss << "  restrict_metrics_to_whitelist: " << (ff::settings.restrict_metrics_to_whitelist ? "true" : "false") << "\n";
     ss << "  whitelisted_ips:\n";
     for (const auto& ip : ff::settings.whitelisted_ips) {
         ss << "    - " << ip << "\n";
@@ -214,8 +267,7 @@ std::string ff::generate_default_config() {
     ss << "#   warning_file: The path to the warning log file.\n";
     ss << "#   error_file: The path to the error log file.\n";
     ss << "#   notice_file: The path to the notice log file.\n";
-    ss << "#   cache_static: Whether to cache static files. (Experimental)\n";
-    ss << "#   cache_exists: Whether to cache the existence of files. (Experimental)\n";
+    ss << "#   cache_static: Whether to keep static files in memory without checking them for changes on disk.\n";
     ss << "filesystem:\n";
     ss << "  session_directory: \"" << ff::settings.session_directory << "\"\n";
     ss << "  data_directory: \"" << ff::settings.data_directory << "\"\n";
@@ -229,17 +281,24 @@ std::string ff::generate_default_config() {
     ss << "  error_file: \"" << ff::settings.error_file << "\"\n";
     ss << "  notice_file: \"" << ff::settings.notice_file << "\"\n";
     ss << "  cache_static: " << (ff::settings.cache_static ? "true" : "false") << "\n";
-    ss << "  cache_exists: " << (ff::settings.cache_exists ? "true" : "false") << "\n";
     ss << "\n";
     ss << "# Database options:\n";
     ss << "#   type: The type of database to use. (sqlite3, postgresql)\n";
+    ss << "#   pool_size: The number of worker threads, each with its own database connection. 0 uses one per CPU core.\n";
+    ss << "#   statement_cache_size: The number of prepared statements each connection keeps.\n";
+    ss << "#   json_cache_size: The approximate number of bytes of parsed rows each worker keeps cached.\n";
     ss << "database:\n";
     ss << "  type: \"" << (ff::settings.enabled_database ? "postgresql" : "sqlite3") << "\"\n";
+    ss << "  pool_size: " << ff::settings.database_pool_size << "\n";
+    ss << "  statement_cache_size: " << ff::settings.database_statement_cache_size << "\n";
+    ss << "  json_cache_size: " << ff::settings.json_cache_size << "\n";
     ss << "\n";
     ss << "# SQLite3 options:\n";
     ss << "#   sqlite_database_file: The path to the SQLite3 database file.\n";
+    ss << "#   busy_timeout: How long in milliseconds a connection waits for a lock held by another before giving up.\n";
     ss << "sqlite3:\n";
     ss << "  sqlite_database_file: \"" << ff::settings.sqlite_database_file << "\"\n";
+    ss << "  busy_timeout: " << ff::settings.sqlite_busy_timeout << "\n";
     ss << "\n";
     ss << "# PostgreSQL options:\n";
     ss << "#   database: The PostgreSQL database.\n";
@@ -271,11 +330,15 @@ std::string ff::generate_default_config() {
     ss << "# Upload options:\n";
     ss << "#   max_request_size: The maximum request size in bytes. Any larger will be rejected by the server\n";
     ss << "#   max_file_size_hash: The maximum file size in bytes that can be hashed. Any larger will not be hashed.\n";
+    ss << "#   max_json_part_size: The maximum size in bytes of the JSON part of an upload.\n";
+    ss << "#   max_image_part_size: The maximum size in bytes of an uploaded banner or icon.\n";
     ss << "#   convert_images_to_webp: Whether to convert images to WebP format. Has a minor performance impact.\n";
     ss << "#   convert_videos_to_webm: Whether to convert videos to WebM format. Has a relatively major performance impact; disable on low end hardware or servers without dedicated GPUs. For reference, even my M1 MacBook Air struggles. In the future, we should add faster presets as options here.\n";
     ss << "upload:\n";
     ss << "  max_request_size: " << ff::settings.max_request_size << "\n";
     ss << "  max_file_size_hash: " << ff::settings.max_file_size_hash << "\n";
+    ss << "  max_json_part_size: " << ff::settings.max_json_part_size << "\n";
+    ss << "  max_image_part_size: " << ff::settings.max_image_part_size << "\n";
     ss << "  convert_images_to_webp: " << (ff::settings.convert_images_to_webp ? "true" : "false") << "\n";
     ss << "  convert_videos_to_webm: " << (ff::settings.convert_videos_to_webm ? "true" : "false") << "\n";
     ss << "\n";
@@ -285,8 +348,16 @@ std::string ff::generate_default_config() {
 	ss << "  topics_require_admin: " << (ff::settings.topics_require_admin ? "true" : "false") << "\n";
     ss << "# Download options:\n";
     ss << "#   preview_files: Whether to preview files in the browser when downloading them.\n";
+    ss << "#   offload: Let a reverse proxy send the file contents. (none, x-accel-redirect, x-sendfile)\n";
+    ss << "#   offload_prefix: The internal location that maps to the data directory, used with x-accel-redirect.\n";
+    ss << "#   event_buffer_size: The most download events to hold in memory before they are written. Any more are dropped.\n";
+    ss << "#   event_flush_interval: How often, in milliseconds, download events are written to the database.\n";
     ss << "download:\n";
     ss << "  preview_files: " << (ff::settings.preview_files ? "true" : "false") << "\n";
+    ss << "  offload: \"" << (ff::settings.download_offload == DownloadOffload::XAccelRedirect ? "x-accel-redirect" : ff::settings.download_offload == DownloadOffload::XSendfile ? "x-sendfile" : "none") << "\"\n";
+    ss << "  offload_prefix: \"" << ff::settings.download_offload_prefix << "\"\n";
+    ss << "  event_buffer_size: " << ff::settings.download_log_buffer_size << "\n";
+    ss << "  event_flush_interval: " << ff::settings.download_log_flush_interval << "\n";
     ss << "\n";
     ss << "# Custom paths:\n";
     ss << "#   These are paths to files that are not in the default directories.\n";
@@ -1,10 +1,794 @@
+#include <algorithm>
 #include <ff.hpp>
+#include <json_cache.hpp>
 #include <scrypto.hpp>
 #include <nlohmann/json.hpp>
 
+std::unique_ptr<ff::database> ff::open_database() {
+    auto database = std::make_unique<ff::database>(settings.enabled_database);
+
+    if (settings.enabled_database) {
+#ifdef FF_ENABLE_POSTGRESQL
+        database->open_postgres(settings.psql_host,
+            settings.psql_username,
+            settings.psql_password,
+            settings.psql_database,
+            settings.psql_port);
+
+#ifdef FF_DEBUG
+        ff::logger.write_to_log(limhamn::logger::type::notice, "PostgreSQL database opened with host: " + settings.psql_host + ", username: " + settings.psql_username + ", password: " + settings.psql_password + ", database: " + settings.psql_database + "\n");
+#endif
+#endif
+    } else {
+#ifdef FF_ENABLE_SQLITE
+        database->open_sqlite(settings.sqlite_database_file);
+#endif
+    }
+
+    if (!database->good()) {
+        ff::fatal = true;
+        throw std::runtime_error{"Error opening the database file."};
+    }
+
+    // WAL lets readers on other connections run while one of them writes,
+    // and busy_timeout makes a writer wait for the lock instead of failing
+    if (!settings.enabled_database) {
+        database->query("PRAGMA journal_mode=WAL;");
+        database->query("PRAGMA synchronous=NORMAL;");
+        database->query("PRAGMA busy_timeout=" + std::to_string(settings.sqlite_busy_timeout) + ";");
+    }
+
+    return database;
+}
+
+namespace {
+    struct Migration {
+        int64_t version{0};
+        std::string description{};
+        void (*apply)(ff::database&){nullptr};
+    };
+
+    void run_statement(ff::database& database, const std::string& statement) {
+        if (!database.exec(statement)) {
+            throw std::runtime_error{"Failed to run statement: " + statement};
+        }
+    }
+
+    std::string to_lower(std::string str) {
+        std::transform(str.begin(), str.end(), str.begin(), ::tolower);
+        return str;
+    }
+
+    /* Listings filter forwarders and sandbox files on a few fields of their JSON, so
+     * those are mirrored into columns of their own whenever the JSON is written;
+     * the same goes for the public profile fields of users.
+     * Text is stored lowercase because the filters are case-insensitive, and fields
+     * missing from the JSON are stored as NULL. Ratings are kept in the ratings table
+     * and are not part of the JSON, see ff::set_rating(), and downloads are counted
+     * by ff::DownloadLog, from the downloads of the files of the upload.
+     */
+    std::vector<std::pair<std::string, ff::DatabaseParameter>> get_listing_columns(const std::string& table, const std::string& json_str) {
+        if (table != "forwarders" && table != "sandbox" && table != "users") {
+            return {};
+        }
+
+        nlohmann::json json{};
+        try {
+            json = nlohmann::json::parse(json_str);
+        } catch (const std::exception&) {
+            json = nlohmann::json::object();
+        }
+        if (!json.is_object()) {
+            json = nlohmann::json::object();
+        }
+
+        nlohmann::json meta = nlohmann::json::object();
+        if (json.find("meta") != json.end() && json.at("meta").is_object()) {
+            meta = json.at("meta");
+        }
+
+        const auto get_text = [](const nlohmann::json& object, const std::string& key) -> ff::DatabaseParameter {
+            if (object.find(key) != object.end() && object.at(key).is_string()) {
+                return to_lower(object.at(key).get<std::string>());
+            }
+            return std::monostate{};
+        };
+        const auto get_integer = [](const nlohmann::json& object, const std::string& key) -> ff::DatabaseParameter {
+            if (object.find(key) != object.end() && object.at(key).is_boolean()) {
+                return static_cast<int64_t>(object.at(key).get<bool>());
+            }
+            if (object.find(key) != object.end() && object.at(key).is_number_integer()) {
+                return object.at(key).get<int64_t>();
+            }
+            return std::monostate{};
+        };
+
+        // the public part of a user's profile, as it is shown to others, so it can be read without the rest of the JSON
+        if (table == "users") {
+            nlohmann::json profile = nlohmann::json::object();
+            if (json.find("profile") != json.end() && json.at("profile").is_object()) {
+                profile = json.at("profile");
+            }
+
+            const auto get_string = [&profile](const std::string& key) -> ff::DatabaseParameter {
+                if (profile.find(key) != profile.end() && profile.at(key).is_string()) {
+                    return profile.at(key).get<std::string>();
+                }
+                return std::monostate{};
+            };
+
+            return {
+                {"display_name", get_string("display_name")},
+                {"description", get_string("description")},
+                {"profile_key", get_string("profile_key")},
+            };
+        }
+
+        std::vector<std::pair<std::string, ff::DatabaseParameter>> columns{
+            {"needs_review", get_integer(json, "needs_review")},
+            {"uploader", get_text(json, "uploader")},
+            {"author", get_text(meta, "author")},
+            {"submitted", get_integer(json, "submitted")},
+        };
+
+        if (table == "forwarders") {
+            columns.emplace_back("type", get_integer(meta, "type"));
+            columns.emplace_back("location", get_text(meta, "location"));
+            columns.emplace_back("title_id", get_text(meta, "title_id"));
+            columns.emplace_back("vwii_compatible", get_integer(meta, "vwii_compatible"));
+        } else {
+            columns.emplace_back("title", get_text(meta, "title"));
+        }
+
+        return columns;
+    }
+
+    // the files that are downloads of an upload; banners, icons and screenshots are not counted
+    std::vector<std::string> get_item_files(const std::string& table, const std::string& json_str) {
+        nlohmann::json json{};
+        try {
+            json = nlohmann::json::parse(json_str);
+        } catch (const std::exception&) {
+            return {};
+        }
+        if (!json.is_object()) {
+            return {};
+        }
+
+        std::vector<std::string> files{};
+        if (table == "forwarders" && json.find("data_download_key") != json.end() && json.at("data_download_key").is_string()) {
+            files.push_back(json.at("data_download_key").get<std::string>());
+        }
+        if (table == "sandbox" && json.find("data") != json.end() && json.at("data").is_array()) {
+            for (const auto& it : json.at("data")) {
+                if (it.is_object() && it.find("download_key") != it.end() && it.at("download_key").is_string()) {
+                    files.push_back(it.at("download_key").get<std::string>());
+                }
+            }
+        }
+
+        return files;
+    }
+
+    // record which upload the files of a forwarder or sandbox file belong to, so their downloads count towards it
+    bool link_item_files(ff::database& database, const std::string& table, const int64_t id, const std::string& json) {
+        for (const auto& it : get_item_files(table, json)) {
+            if (!database.exec("UPDATE files SET item_kind = ?, item_id = ? WHERE file_id = ?;", table, id, it)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // fill in listing columns added by a migration, from the JSON of every existing row
+    void backfill_listing_columns(ff::database& database, const std::string& table, const std::vector<std::string>& names) {
+        for (const auto& row : database.query("SELECT id, json FROM " + table + ";")) {
+            std::string query{"UPDATE " + table + " SET "};
+            std::vector<ff::DatabaseParameter> parameters{};
+
+            for (auto& it : get_listing_columns(table, row.at("json"))) {
+                if (std::find(names.begin(), names.end(), it.first) == names.end()) {
+                    continue;
+                }
+                query += (parameters.empty() ? "" : ", ") + it.first + " = ?";
+                parameters.push_back(std::move(it.second));
+            }
+
+            query += " WHERE id = ?;";
+            parameters.emplace_back(std::stoll(row.at("id")));
+
+            if (!database.exec(query, parameters)) {
+                throw std::runtime_error{"Failed to backfill " + table + " row " + row.at("id")};
+            }
+        }
+    }
+
+    // the path of a patch, as a SQLite JSON path or a PostgreSQL text[] literal
+    std::string make_json_path(const std::vector<std::string>& path, const bool postgres) {
+        if (postgres) {
+            std::string ret{"{"};
+            for (const auto& it : path) {
+                ret += ret.size() == 1 ? "\"" : ",\"";
+                for (const char c : it) {
+                    if (c == '"' || c == '\\') {
+                        ret += '\\';
+                    }
+                    ret += c;
+                }
+                ret += '"';
+            }
+            return ret + "}";
+        }
+
+        std::string ret{"$"};
+        for (const auto& it : path) {
+            ret += ".\"" + it + "\"";
+        }
+        return ret;
+    }
+
+    /* Wraps expression, which evaluates to the document, in the SQL that applies patch
+     * to it. Every patch reads the document once, through a subquery, so the parameters
+     * of the expression are only bound once however many patches are stacked. The
+     * parameters of patch come first in the SQL, so they are put in front of those of
+     * the expression.
+     */
+    std::string make_json_patch_expression(const std::string& expression, const ff::JsonPatch& patch, const bool postgres, std::vector<ff::DatabaseParameter>& expression_parameters) {
+        const std::string path = make_json_path(patch.path, postgres);
+        const std::string from = " FROM (SELECT " + expression + " AS document) AS patched)";
+
+        std::vector<ff::DatabaseParameter> parameters{};
+        const auto wrap = [&](const std::string& sql) -> std::string {
+            expression_parameters.insert(expression_parameters.begin(), parameters.begin(), parameters.end());
+            return sql + from;
+        };
+
+        if (postgres) {
+            switch (patch.operation) {
+                case ff::JsonPatchOperation::Set:
+                    parameters.emplace_back(path);
+                    parameters.emplace_back(patch.value.dump());
+                    return wrap("(SELECT jsonb_set(document, CAST(? AS text[]), CAST(? AS jsonb), true)");
+                case ff::JsonPatchOperation::Append:
+                    parameters.emplace_back(path);
+                    parameters.emplace_back(path);
+                    parameters.emplace_back(path);
+                    parameters.emplace_back(patch.value.dump());
+                    return wrap("(SELECT jsonb_set(document, CAST(? AS text[]), CASE WHEN jsonb_typeof(document #> CAST(? AS text[])) = 'array' "
+                        "THEN document #> CAST(? AS text[]) ELSE '[]'::jsonb END || jsonb_build_array(CAST(? AS jsonb)), true)");
+                case ff::JsonPatchOperation::Remove:
+                    parameters.emplace_back(path);
+                    return wrap("(SELECT document #- CAST(? AS text[])");
+            }
+        }
+
+        switch (patch.operation) {
+            case ff::JsonPatchOperation::Set:
+                parameters.emplace_back(path);
+                parameters.emplace_back(patch.value.dump());
+                return wrap("(SELECT json_set(document, ?, json(?))");
+            case ff::JsonPatchOperation::Append:
+                parameters.emplace_back(path);
+                parameters.emplace_back(path);
+                parameters.emplace_back(path + "[#]");
+                parameters.emplace_back(patch.value.dump());
+                return wrap("(SELECT json_insert(CASE WHEN json_type(document, ?) = 'array' THEN document ELSE json_set(document, ?, json('[]')) END, ?, json(?))");
+            case ff::JsonPatchOperation::Remove:
+                parameters.emplace_back(path);
+                return wrap("(SELECT json_remove(document, ?)");
+        }
+
+        throw std::runtime_error{"Unknown JSON patch operation."};
+    }
+
+    // the same change as make_json_patch_expression(), made to a parsed document
+    void apply_json_patch(nlohmann::json& json, const ff::JsonPatch& patch) {
+        if (patch.path.empty()) {
+            return;
+        }
+
+        nlohmann::json* parent = &json;
+        for (std::size_t i{0}; i + 1 < patch.path.size(); ++i) {
+            if (!parent->is_object() || parent->find(patch.path[i]) == parent->end()) {
+                return;
+            }
+            parent = &parent->at(patch.path[i]);
+        }
+        if (!parent->is_object()) {
+            return;
+        }
+
+        const std::string& key = patch.path.back();
+        switch (patch.operation) {
+            case ff::JsonPatchOperation::Set:
+                (*parent)[key] = patch.value;
+                break;
+            case ff::JsonPatchOperation::Append:
+                if (parent->find(key) == parent->end() || !parent->at(key).is_array()) {
+                    (*parent)[key] = nlohmann::json::array();
+                }
+                (*parent)[key].push_back(patch.value);
+                break;
+            case ff::JsonPatchOperation::Remove:
+                parent->erase(key);
+                break;
+        }
+    }
+
+    // the fields of the JSON that searches match, see create_search_index()
+    std::vector<std::pair<std::string, std::string>> get_search_fields(const std::string& table) {
+        if (table == "forwarders") {
+            return {
+                {"title", "meta,title"},
+                {"title_id", "meta,title_id"},
+                {"author", "meta,author"},
+                {"uploader", "uploader"},
+                {"description", "meta,description"},
+            };
+        }
+
+        return {
+            {"title", "meta,title"},
+            {"filenames", "meta,filenames"},
+            {"author", "meta,author"},
+            {"uploader", "uploader"},
+            {"description", "meta,description"},
+        };
+    }
+
+    /* Builds the full-text index that searches run against. Fields are given from the
+     * most to the least important, two per weight and then the rest; on SQLite those
+     * weights are applied with bm25() when searching instead. SQLite keeps an FTS5
+     * table in sync with triggers, and PostgreSQL a generated tsvector column, so
+     * every insert, update and delete of the table is covered.
+     */
+    void create_search_index(ff::database& database, const std::string& table, const std::vector<std::pair<std::string, std::string>>& fields) {
+        if (database.is_postgres()) {
+            const auto get_text = [&](const std::size_t begin, const std::size_t end) -> std::string {
+                std::string text{};
+                for (std::size_t i{begin}; i < end && i < fields.size(); ++i) {
+                    text += (text.empty() ? "" : " || ' ' || ") + std::string{"coalesce(json::jsonb #>> '{"} + fields[i].second + "}', '')";
+                }
+                return text;
+            };
+
+            run_statement(database, "ALTER TABLE " + table + " ADD COLUMN search tsvector GENERATED ALWAYS AS ("
+                "setweight(to_tsvector('simple', " + get_text(0, 2) + "), 'A') || "
+                "setweight(to_tsvector('simple', " + get_text(2, 4) + "), 'B') || "
+                "setweight(to_tsvector('simple', " + get_text(4, fields.size()) + "), 'C')) STORED;");
+            run_statement(database, "CREATE INDEX IF NOT EXISTS " + table + "_search_index ON " + table + " USING GIN (search);");
+            return;
+        }
+
+        std::string columns{};
+        const auto get_values = [&](const std::string& row) -> std::string {
+            std::string values{};
+            for (const auto& it : fields) {
+                std::string path{it.second};
+                std::replace(path.begin(), path.end(), ',', '.');
+                values += ", json_extract(" + row + "json, '$." + path + "')";
+            }
+            return values;
+        };
+        for (const auto& it : fields) {
+            columns += ", " + it.first;
+        }
+
+        const std::string search_table = table + "_search";
+        const std::string insert = "INSERT INTO " + search_table + " (rowid" + columns + ")";
+
+        run_statement(database, "CREATE VIRTUAL TABLE IF NOT EXISTS " + search_table + " USING fts5(" + columns.substr(2) + ", tokenize = 'unicode61 remove_diacritics 2');");
+        run_statement(database, insert + " SELECT id" + get_values("") + " FROM " + table + " WHERE json_valid(json);");
+        run_statement(database, "CREATE TRIGGER IF NOT EXISTS " + search_table + "_insert AFTER INSERT ON " + table + " WHEN json_valid(new.json) BEGIN " +
+            insert + " SELECT new.id" + get_values("new.") + "; END;");
+        run_statement(database, "CREATE TRIGGER IF NOT EXISTS " + search_table + "_update AFTER UPDATE OF json ON " + table + " BEGIN DELETE FROM " + search_table + " WHERE rowid = old.id; " +
+            insert + " SELECT new.id" + get_values("new.") + " WHERE json_valid(new.json); END;");
+        run_statement(database, "CREATE TRIGGER IF NOT EXISTS " + search_table + "_delete AFTER DELETE ON " + table + " BEGIN DELETE FROM " + search_table + " WHERE rowid = old.id; END;");
+    }
+
+    // whether the text parses as JSON that PostgreSQL can store as jsonb, which has no room for \u0000 in strings or keys
+    bool is_valid_jsonb(const std::string& text) {
+        nlohmann::json json{};
+        try {
+            json = nlohmann::json::parse(text);
+        } catch (const std::exception&) {
+            return false;
+        }
+
+        const std::function<bool(const nlohmann::json&)> has_no_nul = [&](const nlohmann::json& value) {
+            if (value.is_string()) {
+                return value.get_ref<const std::string&>().find('\0') == std::string::npos;
+            }
+            if (value.is_object()) {
+                for (const auto& it : value.items()) {
+                    if (it.key().find('\0') != std::string::npos || !has_no_nul(it.value())) {
+                        return false;
+                    }
+                }
+            }
+            if (value.is_array()) {
+                for (const auto& it : value) {
+                    if (!has_no_nul(it)) {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        };
+
+        return has_no_nul(json);
+    }
+
+    // append new migrations to the end; never edit or reorder ones that have been released
+    const std::vector<Migration>& get_migrations() {
+        static const std::vector<Migration> migrations{
+            {1, "Index lookup columns", [](ff::database& database) {
+                run_statement(database, "CREATE INDEX IF NOT EXISTS users_username_index ON users (username);");
+                run_statement(database, "CREATE INDEX IF NOT EXISTS users_email_index ON users (email);");
+                run_statement(database, "CREATE INDEX IF NOT EXISTS files_file_id_index ON files (file_id);");
+                run_statement(database, "CREATE INDEX IF NOT EXISTS forwarders_identifier_index ON forwarders (identifier);");
+                run_statement(database, "CREATE INDEX IF NOT EXISTS sandbox_identifier_index ON sandbox (identifier);");
+                run_statement(database, "CREATE INDEX IF NOT EXISTS topics_identifier_index ON topics (identifier);");
+                run_statement(database, "CREATE INDEX IF NOT EXISTS posts_identifier_index ON posts (identifier);");
+                run_statement(database, "CREATE INDEX IF NOT EXISTS activation_urls_url_index ON activation_urls (url);");
+                run_statement(database, "CREATE INDEX IF NOT EXISTS activation_urls_username_index ON activation_urls (username);");
+            }},
+            {2, "Promote listing fields of forwarders and sandbox files to columns", [](ff::database& database) {
+                // needs_review: 1 if the upload is waiting for approval
+                // uploader, author: lowercase
+                // submitted: the time the upload was submitted
+                // type: 1 = channel, 0 = forwarder
+                // location, title_id: lowercase
+                // vwii_compatible: 1 if the forwarder works on the vWii
+                // title: lowercase
+                run_statement(database, "ALTER TABLE forwarders ADD COLUMN needs_review bigint;");
+                run_statement(database, "ALTER TABLE forwarders ADD COLUMN uploader TEXT;");
+                run_statement(database, "ALTER TABLE forwarders ADD COLUMN author TEXT;");
+                run_statement(database, "ALTER TABLE forwarders ADD COLUMN submitted bigint;");
+                run_statement(database, "ALTER TABLE forwarders ADD COLUMN type bigint;");
+                run_statement(database, "ALTER TABLE forwarders ADD COLUMN location TEXT;");
+                run_statement(database, "ALTER TABLE forwarders ADD COLUMN title_id TEXT;");
+                run_statement(database, "ALTER TABLE forwarders ADD COLUMN vwii_compatible bigint;");
+                run_statement(database, "ALTER TABLE sandbox ADD COLUMN needs_review bigint;");
+                run_statement(database, "ALTER TABLE sandbox ADD COLUMN uploader TEXT;");
+                run_statement(database, "ALTER TABLE sandbox ADD COLUMN author TEXT;");
+                run_statement(database, "ALTER TABLE sandbox ADD COLUMN submitted bigint;");
+                run_statement(database, "ALTER TABLE sandbox ADD COLUMN title TEXT;");
+
+                backfill_listing_columns(database, "forwarders", {"needs_review", "uploader", "author", "submitted", "type", "location", "title_id", "vwii_compatible"});
+                backfill_listing_columns(database, "sandbox", {"needs_review", "uploader", "author", "submitted", "title"});
+
+                // type and vwii_compatible only have two values, so they are left to be filtered after needs_review
+                run_statement(database, "CREATE INDEX IF NOT EXISTS forwarders_needs_review_index ON forwarders (needs_review, id);");
+                run_statement(database, "CREATE INDEX IF NOT EXISTS forwarders_uploader_index ON forwarders (uploader);");
+                run_statement(database, "CREATE INDEX IF NOT EXISTS forwarders_author_index ON forwarders (author);");
+                run_statement(database, "CREATE INDEX IF NOT EXISTS forwarders_submitted_index ON forwarders (submitted);");
+                run_statement(database, "CREATE INDEX IF NOT EXISTS forwarders_location_index ON forwarders (location);");
+                run_statement(database, "CREATE INDEX IF NOT EXISTS forwarders_title_id_index ON forwarders (title_id);");
+                run_statement(database, "CREATE INDEX IF NOT EXISTS sandbox_needs_review_index ON sandbox (needs_review, id);");
+                run_statement(database, "CREATE INDEX IF NOT EXISTS sandbox_uploader_index ON sandbox (uploader);");
+                run_statement(database, "CREATE INDEX IF NOT EXISTS sandbox_author_index ON sandbox (author);");
+                run_statement(database, "CREATE INDEX IF NOT EXISTS sandbox_submitted_index ON sandbox (submitted);");
+                run_statement(database, "CREATE INDEX IF NOT EXISTS sandbox_title_index ON sandbox (title);");
+            }},
+            {3, "Add sort columns for paginated listings", [](ff::database& database) {
+                // downloads: the number of times the files of the upload were downloaded
+                // rating: the average rating of the upload
+                run_statement(database, "ALTER TABLE forwarders ADD COLUMN downloads bigint NOT NULL DEFAULT 0;");
+                run_statement(database, "ALTER TABLE forwarders ADD COLUMN rating bigint NOT NULL DEFAULT 0;");
+                run_statement(database, "ALTER TABLE sandbox ADD COLUMN downloads bigint NOT NULL DEFAULT 0;");
+                run_statement(database, "ALTER TABLE sandbox ADD COLUMN rating bigint NOT NULL DEFAULT 0;");
+
+                // rating is filled in by migration 6, from the ratings it moves out of the JSON
+
+                // item_kind: the table of the upload the file is a download of, forwarders or sandbox; NULL for banners, icons and the like
+                // item_id: the id of that upload
+                run_statement(database, "ALTER TABLE files ADD COLUMN item_kind TEXT;");
+                run_statement(database, "ALTER TABLE files ADD COLUMN item_id bigint;");
+                run_statement(database, "CREATE INDEX IF NOT EXISTS files_item_index ON files (item_kind, item_id);");
+
+                for (const std::string table : {"forwarders", "sandbox"}) {
+                    for (const auto& row : database.query("SELECT id, json FROM " + table + ";")) {
+                        if (!link_item_files(database, table, std::stoll(row.at("id")), row.at("json"))) {
+                            throw std::runtime_error{"Failed to link the files of " + table + " row " + row.at("id")};
+                        }
+                    }
+                }
+
+                // the downloads of the upload are those of its files, which count them in their JSON;
+                // the "downloads" of the upload's own JSON was never incremented
+                std::unordered_map<std::string, std::unordered_map<int64_t, int64_t>> downloads{};
+                for (const auto& row : database.query("SELECT item_kind, item_id, json FROM files WHERE item_kind IS NOT NULL;")) {
+                    nlohmann::json json{};
+                    try {
+                        json = nlohmann::json::parse(row.at("json"));
+                    } catch (const std::exception&) {
+                        continue;
+                    }
+
+                    if (json.is_object() && json.contains("downloads") && json.at("downloads").is_number_integer()) {
+                        downloads[row.at("item_kind")][std::stoll(row.at("item_id"))] += json.at("downloads").get<int64_t>();
+                    }
+                }
+                for (const auto& [table, ids] : downloads) {
+                    for (const auto& [id, count] : ids) {
+                        if (!database.exec("UPDATE " + table + " SET downloads = ? WHERE id = ?;", count, id)) {
+                            throw std::runtime_error{"Failed to count the downloads of " + table + " row " + std::to_string(id)};
+                        }
+                    }
+                }
+
+                // public listings always filter on needs_review; the id breaks ties, so a cursor is never ambiguous
+                run_statement(database, "CREATE INDEX IF NOT EXISTS forwarders_downloads_index ON forwarders (needs_review, downloads, id);");
+                run_statement(database, "CREATE INDEX IF NOT EXISTS forwarders_rating_index ON forwarders (needs_review, rating, id);");
+                run_statement(database, "CREATE INDEX IF NOT EXISTS sandbox_downloads_index ON sandbox (needs_review, downloads, id);");
+                run_statement(database, "CREATE INDEX IF NOT EXISTS sandbox_rating_index ON sandbox (needs_review, rating, id);");
+            }},
+            {4, "Add full-text search indexes", [](ff::database& database) {
+                create_search_index(database, "forwarders", get_search_fields("forwarders"));
+                create_search_index(database, "sandbox", get_search_fields("sandbox"));
+            }},
+            {5, "Move downloads of files out of their JSON", [](ff::database& database) {
+                // id: the event id
+                // file_id: the file that was downloaded
+                // username: the user who downloaded it, or _nouser_
+                // ip_address: the ip address of the downloader
+                // user_agent: the user agent of the downloader
+                // timestamp: the time of the download
+                run_statement(database, std::string{"CREATE TABLE IF NOT EXISTS download_events ("} + (database.is_postgres() ? "id BIGSERIAL PRIMARY KEY" : "id INTEGER PRIMARY KEY") +
+                    ", file_id TEXT NOT NULL, username TEXT NOT NULL, ip_address TEXT NOT NULL, user_agent TEXT NOT NULL, timestamp bigint NOT NULL);");
+                run_statement(database, "CREATE INDEX IF NOT EXISTS download_events_file_id_index ON download_events (file_id);");
+
+                // downloads: the number of times the file was downloaded
+                run_statement(database, "ALTER TABLE files ADD COLUMN downloads bigint NOT NULL DEFAULT 0;");
+
+                for (const auto& row : database.query("SELECT id, file_id, json FROM files;")) {
+                    nlohmann::json json{};
+                    try {
+                        json = nlohmann::json::parse(row.at("json"));
+                    } catch (const std::exception&) {
+                        continue;
+                    }
+                    if (!json.is_object()) {
+                        continue;
+                    }
+
+                    if (json.contains("downloaders") && json.at("downloaders").is_array()) {
+                        for (const auto& it : json.at("downloaders")) {
+                            if (!it.is_object()) {
+                                continue;
+                            }
+
+                            const auto get_text = [&it](const std::string& key) -> std::string {
+                                return it.contains(key) && it.at(key).is_string() ? it.at(key).get<std::string>() : "";
+                            };
+
+                            if (!database.exec("INSERT INTO download_events (file_id, username, ip_address, user_agent, timestamp) VALUES (?, ?, ?, ?, ?);",
+                                row.at("file_id"), get_text("username"), get_text("ip_address"), get_text("user_agent"),
+                                it.contains("timestamp") && it.at("timestamp").is_number_integer() ? it.at("timestamp").get<int64_t>() : int64_t{0})) {
+                                throw std::runtime_error{"Failed to move the downloads of file " + row.at("file_id")};
+                            }
+                        }
+                    }
+
+                    const int64_t downloads = json.contains("downloads") && json.at("downloads").is_number_integer() ? json.at("downloads").get<int64_t>() : 0;
+
+                    json.erase("downloaders");
+                    json.erase("downloads");
+
+                    if (!database.exec("UPDATE files SET downloads = ?, json = ? WHERE id = ?;", downloads, json.dump(), std::stoll(row.at("id")))) {
+                        throw std::runtime_error{"Failed to update file " + row.at("file_id")};
+                    }
+                }
+            }},
+            {6, "Move ratings of forwarders and sandbox files out of their JSON", [](ff::database& database) {
+                // kind: the table of the rated upload, forwarders or sandbox
+                // identifier: the identifier of the rated upload
+                // username: the user who rated it
+                // rating: 1 to 5
+                run_statement(database, "CREATE TABLE IF NOT EXISTS ratings (kind TEXT NOT NULL, identifier TEXT NOT NULL, username TEXT NOT NULL, rating bigint NOT NULL, PRIMARY KEY (kind, identifier, username));");
+
+                // rating_sum, rating_count: the sum and number of the ratings of the upload
+                // rating: from now on the average rating times 100, so uploads with close averages still sort apart
+                for (const std::string table : {"forwarders", "sandbox"}) {
+                    run_statement(database, "ALTER TABLE " + table + " ADD COLUMN rating_sum bigint NOT NULL DEFAULT 0;");
+                    run_statement(database, "ALTER TABLE " + table + " ADD COLUMN rating_count bigint NOT NULL DEFAULT 0;");
+
+                    for (const auto& row : database.query("SELECT id, identifier, json FROM " + table + ";")) {
+                        nlohmann::json json{};
+                        try {
+                            json = nlohmann::json::parse(row.at("json"));
+                        } catch (const std::exception&) {
+                            continue;
+                        }
+                        if (!json.is_object()) {
+                            continue;
+                        }
+
+                        int64_t sum{0};
+                        int64_t count{0};
+                        if (json.contains("ratings") && json.at("ratings").is_object()) {
+                            for (const auto& it : json.at("ratings").items()) {
+                                if (!it.value().is_object() || !it.value().contains("rating") || !it.value().at("rating").is_number_integer()) {
+                                    continue;
+                                }
+
+                                const int64_t rating = it.value().at("rating").get<int64_t>();
+                                if (rating < 1 || rating > 5) {
+                                    continue;
+                                }
+
+                                if (!database.exec("INSERT INTO ratings (kind, identifier, username, rating) VALUES (?, ?, ?, ?);", table, row.at("identifier"), it.key(), rating)) {
+                                    throw std::runtime_error{"Failed to move the ratings of " + table + " row " + row.at("id")};
+                                }
+                                sum += rating;
+                                ++count;
+                            }
+                        }
+
+                        json.erase("ratings");
+
+                        if (!database.exec("UPDATE " + table + " SET rating_sum = ?, rating_count = ?, rating = ?, json = ? WHERE id = ?;",
+                            sum, count, count > 0 ? sum * 100 / count : int64_t{0}, json.dump(), std::stoll(row.at("id")))) {
+                            throw std::runtime_error{"Failed to update " + table + " row " + row.at("id")};
+                        }
+                    }
+                }
+            }},
+            {7, "Move comments of forwarders and sandbox files out of their JSON", [](ff::database& database) {
+                // id: the comment id; comments of an upload are listed in the order of their ids
+                // kind: the table of the upload, forwarders or sandbox
+                // identifier: the identifier of the upload
+                // username: the user who wrote the comment
+                // created_at: the time the comment was written
+                // json: the comment, timestamp and username of the comment
+                run_statement(database, std::string{"CREATE TABLE IF NOT EXISTS comments ("} + (database.is_postgres() ? "id BIGSERIAL PRIMARY KEY" : "id INTEGER PRIMARY KEY") +
+                    ", kind TEXT NOT NULL, identifier TEXT NOT NULL, username TEXT NOT NULL, created_at bigint NOT NULL, json TEXT NOT NULL);");
+                run_statement(database, "CREATE INDEX IF NOT EXISTS comments_item_index ON comments (kind, identifier, id);");
+
+                // comment_count: the number of comments on the upload
+                for (const std::string table : {"forwarders", "sandbox"}) {
+                    run_statement(database, "ALTER TABLE " + table + " ADD COLUMN comment_count bigint NOT NULL DEFAULT 0;");
+
+                    for (const auto& row : database.query("SELECT id, identifier, json FROM " + table + ";")) {
+                        nlohmann::json json{};
+                        try {
+                            json = nlohmann::json::parse(row.at("json"));
+                        } catch (const std::exception&) {
+                            continue;
+                        }
+                        if (!json.is_object()) {
+                            continue;
+                        }
+
+                        int64_t count{0};
+                        if (json.contains("reviews") && json.at("reviews").is_array()) {
+                            for (const auto& it : json.at("reviews")) {
+                                if (!it.is_object() || !it.contains("username") || !it.at("username").is_string()) {
+                                    continue;
+                                }
+
+                                const int64_t created_at = it.contains("timestamp") && it.at("timestamp").is_number_integer() ? it.at("timestamp").get<int64_t>() : 0;
+                                if (!database.exec("INSERT INTO comments (kind, identifier, username, created_at, json) VALUES (?, ?, ?, ?, ?);",
+                                    table, row.at("identifier"), it.at("username").get<std::string>(), created_at, it.dump())) {
+                                    throw std::runtime_error{"Failed to move the comments of " + table + " row " + row.at("id")};
+                                }
+                                ++count;
+                            }
+                        }
+
+                        json.erase("reviews");
+
+                        if (!database.exec("UPDATE " + table + " SET comment_count = ?, json = ? WHERE id = ?;", count, json.dump(), std::stoll(row.at("id")))) {
+                            throw std::runtime_error{"Failed to update " + table + " row " + row.at("id")};
+                        }
+                    }
+                }
+            }},
+            {8, "Promote public profile fields of users to columns", [](ff::database& database) {
+                // display_name, description, profile_key: as in [profile], NULL if unset
+                run_statement(database, "ALTER TABLE users ADD COLUMN display_name TEXT;");
+                run_statement(database, "ALTER TABLE users ADD COLUMN description TEXT;");
+                run_statement(database, "ALTER TABLE users ADD COLUMN profile_key TEXT;");
+
+                backfill_listing_columns(database, "users", {"display_name", "description", "profile_key"});
+            }},
+            {9, "Stamp rows holding json with a version", [](ff::database& database) {
+                // version: bumped on every write of json, so a parsed copy of a row can be checked for staleness
+                for (const std::string table : {"users", "forwarders", "sandbox", "files", "general", "topics", "posts"}) {
+                    run_statement(database, "ALTER TABLE " + table + " ADD COLUMN version bigint NOT NULL DEFAULT 0;");
+                }
+            }},
+            {10, "Store the json of rows as jsonb", [](ff::database& database) {
+                // SQLite keeps text: its json functions take text as well, and the JSON is parsed from text either way
+                if (!database.is_postgres()) {
+                    return;
+                }
+
+                // a single row that jsonb cannot hold would fail the cast and with it the whole migration, so such rows are
+                // copied here and their json replaced with an empty object
+                // kind: the table the row was in
+                // row_id: the id of the row in that table
+                // json: the text that could not be stored as jsonb
+                // quarantined_at: the time the row was moved
+                run_statement(database, "CREATE TABLE IF NOT EXISTS quarantined_json (id BIGSERIAL PRIMARY KEY, kind TEXT NOT NULL, row_id bigint NOT NULL, json TEXT NOT NULL, quarantined_at bigint NOT NULL);");
+
+                const std::vector<std::string> tables{"users", "forwarders", "sandbox", "files", "general", "topics", "posts", "comments"};
+                for (const auto& table : tables) {
+                    for (const auto& row : database.query("SELECT id, json FROM " + table + ";")) {
+                        if (is_valid_jsonb(row.at("json"))) {
+                            continue;
+                        }
+
+                        ff::logger.write_to_log(limhamn::logger::type::warning, "The json of " + table + " row " + row.at("id") + " cannot be stored as jsonb; it was moved to quarantined_json and replaced with {}.\n");
+
+                        if (!database.exec("INSERT INTO quarantined_json (kind, row_id, json, quarantined_at) VALUES (?, ?, ?, ?);",
+                            table, std::stoll(row.at("id")), row.at("json"), scrypto::return_unix_millis())
+                            || !database.exec("UPDATE " + table + " SET json = ? WHERE id = ?;", std::string{"{}"}, std::stoll(row.at("id")))) {
+                            throw std::runtime_error{"Failed to quarantine the json of " + table + " row " + row.at("id")};
+                        }
+                    }
+                }
+
+                // the search column is generated from json, so it has to be rebuilt around the change of type
+                for (const std::string table : {"forwarders", "sandbox"}) {
+                    run_statement(database, "ALTER TABLE " + table + " DROP COLUMN search;");
+                }
+                for (const auto& table : tables) {
+                    run_statement(database, "ALTER TABLE " + table + " ALTER COLUMN json TYPE jsonb USING CAST(json AS jsonb);");
+                }
+                for (const std::string table : {"forwarders", "sandbox"}) {
+                    create_search_index(database, table, get_search_fields(table));
+                }
+            }},
+            {11, "Count changes to the catalogs of forwarders and sandbox files", [](ff::database& database) {
+                // kind: the table, forwarders or sandbox
+                // generation: bumped by every write that changes what the listings of the table return, see ff::touch_catalog()
+                run_statement(database, "CREATE TABLE IF NOT EXISTS catalog_generations (kind TEXT PRIMARY KEY, generation bigint NOT NULL);");
+                run_statement(database, "INSERT INTO catalog_generations (kind, generation) VALUES ('forwarders', 0), ('sandbox', 0);");
+            }},
+        };
+
+        return migrations;
+    }
+}
+
 // implement changes made to the database schema
-void ff::update_to_latest(database&) {
-    // none as of now
+void ff::update_to_latest(database& database) {
+    // version: the schema version a migration brought the database to
+    // applied_at: the time the migration was applied
+    run_statement(database, "CREATE TABLE IF NOT EXISTS schema_version (version bigint NOT NULL, applied_at bigint NOT NULL);");
+
+    int64_t current{0};
+    for (const auto& it : database.query("SELECT MAX(version) AS version FROM schema_version;")) {
+        if (!it.at("version").empty()) {
+            current = std::stoll(it.at("version"));
+        }
+    }
+
+    for (const auto& it : get_migrations()) {
+        if (it.version <= current) {
+            continue;
+        }
+
+        logger.write_to_log(limhamn::logger::type::notice, "Migrating the database to version " + std::to_string(it.version) + ": " + it.description + ".\n");
+
+        // each migration is applied entirely or not at all
+        run_statement(database, "BEGIN;");
+        try {
+            it.apply(database);
+            if (!database.exec("INSERT INTO schema_version (version, applied_at) VALUES (?, ?);", it.version, scrypto::return_unix_millis())) {
+                throw std::runtime_error{"Failed to record schema version " + std::to_string(it.version)};
+            }
+            run_statement(database, "COMMIT;");
+        } catch (const std::exception&) {
+            database.exec("ROLLBACK;");
+            throw;
+        }
+
+        current = it.version;
+    }
 }
 
 void ff::setup_database(database& database) {
@@ -110,9 +894,7 @@ std::string ff::upload_file(database& db, const ff::FileConstruct& c) {
     json["username"] = c.username;
     json["ip_address"] = c.ip_address;
     json["user_agent"] = c.user_agent;
-    json["uploaded_at"] = scrypto::return_unix_millis();
-    json["downloads"] = 0;
-    json["downloaders"] = nlohmann::json::array(); /* combine username, ip address, user agent and timestamp */
+    json["uploaded_at"] = scrypto::return_unix_millis(); // downloads are counted in the downloads column and download_events
 
     const auto check_for_dup = [](database& db, const std::string& key) -> bool {
         for (const auto& it : db.query("SELECT * FROM files WHERE file_id = ?;", key)) {
@@ -229,31 +1011,19 @@ bool ff::is_file(database& db, const std::string& file_key) {
 
 }
 
-ff::RetrievedFile ff::download_file(database& db, const ff::UserProperties& prop, const std::string& file_key) {
+ff::RetrievedFile ff::get_file(database& db, const std::string& file_key) {
     if (!db.good()) {
         throw std::runtime_error{"Database is not good."};
     }
-    if (prop.ip_address.empty() || prop.user_agent.empty() || file_key.empty()) {
-        throw std::runtime_error{"IP address, user agent, or file key is empty."};
-    }
-
-    nlohmann::json downloaders;
-    downloaders["username"] = prop.username;
-    downloaders["ip_address"] = prop.ip_address;
-    downloaders["user_agent"] = prop.user_agent;
-    downloaders["timestamp"] = scrypto::return_unix_millis();
-
-    if (prop.username.empty()) {
-        downloaders["username"] = "_nouser_";
+    if (file_key.empty()) {
+        throw std::runtime_error{"File key is empty."};
     }
 
-    /* select all matching file_key */
-    const auto query = db.query("SELECT * FROM files WHERE file_id = ?;", file_key);
+    const auto query = db.query("SELECT json FROM files WHERE file_id = ?;", file_key);
     if (query.empty()) {
         throw std::runtime_error{"Query is empty."};
     }
 
-    // get json
     nlohmann::json json;
     try {
         json = nlohmann::json::parse(query.at(0).at("json"));
@@ -261,17 +1031,9 @@ ff::RetrievedFile ff::download_file(database& db, const ff::UserProperties& prop
         throw std::runtime_error{"Error parsing JSON."};
     }
 
-    if (json.find("downloads") != json.end() && json.at("downloads").is_number()) {
-        json["downloads"] = json.at("downloads").get<int>() + 1;
-    }
-    if (json.find("downloaders") != json.end() && json.at("downloaders").is_array()) {
-        json["downloaders"].push_back(downloaders);
-    }
     if (json.find("filename") == json.end() || !json.at("filename").is_string()) {
         throw std::runtime_error{"Filename not found."};
     }
-
-    ff::RetrievedFile f;
     if (json.find("path") == json.end() || !json.at("path").is_string()) {
         throw std::runtime_error{"Path not found."};
     }
@@ -279,14 +1041,10 @@ ff::RetrievedFile ff::download_file(database& db, const ff::UserProperties& prop
         throw std::runtime_error{"File is not a regular file: " + json.at("path").get<std::string>()};
     }
 
+    ff::RetrievedFile f;
     f.name = json.at("filename").get<std::string>();
     f.path = json.at("path").get<std::string>();
 
-    // reinsert into the files table
-    if (!db.exec("UPDATE files SET json = ? WHERE file_id = ?;", json.dump(), file_key)) {
-        throw std::runtime_error{"Error updating the files table."};
-    }
-
     return f;
 }
 
@@ -314,10 +1072,342 @@ std::string ff::get_json_from_table(database& db, const std::string& table, cons
     throw std::runtime_error{"JSON not found."};
 }
 
+std::shared_ptr<const nlohmann::json> ff::get_parsed_json_from_table(database& db, const std::string& table, const std::string& key, const std::string& value) {
+    if (!db.good()) {
+        throw std::runtime_error{"Database is not good."};
+    }
+    if (table.empty() || key.empty() || value.empty()) {
+        throw std::runtime_error{"Table, key, or value is empty."};
+    }
+
+    const std::string cache_key = JsonCache::make_key(table, key, value);
+    const CachedJson cached = json_cache.find(cache_key);
+
+    // the json is only sent if the row is not the one we have cached
+    const auto& query = db.query("SELECT id, version, CASE WHEN id = ? AND version = ? THEN NULL ELSE json END AS json FROM " + table + " WHERE " + key + " = ?;",
+        cached.id, cached.version, value);
+    if (query.empty()) {
+        throw std::runtime_error{"Query is empty."};
+    }
+
+    for (const auto& it : query) {
+        if (it.find("json") == it.end() || it.find("id") == it.end() || it.find("version") == it.end()) {
+            throw std::runtime_error{"JSON not found."};
+        }
+
+        const int64_t id = std::stoll(it.at("id"));
+        const int64_t version = std::stoll(it.at("version"));
+
+        if (it.at("json").empty() && cached.json != nullptr && cached.id == id && cached.version == version) {
+            return cached.json;
+        }
+
+        return json_cache.parse(cache_key, id, version, it.at("json"));
+    }
+
+    throw std::runtime_error{"JSON not found."};
+}
+
+std::shared_ptr<const nlohmann::json> ff::get_parsed_json_from_row(const std::string& table, const std::unordered_map<std::string, std::string>& row) {
+    const std::string& id = row.at("id");
+    return json_cache.parse(JsonCache::make_key(table, "id", id), std::stoll(id), std::stoll(row.at("version")), row.at("json"));
+}
+
 bool ff::set_json_in_table(database& db, const std::string& table, const std::string& key, const std::string& value, const std::string& json) {
     if (!db.good() || table.empty() || key.empty() || value.empty() || json.empty()) {
         return false;
     }
 
-    return db.exec("UPDATE " + table + " SET json = ? WHERE " + key + " = ?;", json, value);
+    json_cache.erase(JsonCache::make_key(table, key, value));
+
+    std::string query{"UPDATE " + table + " SET json = ?, version = version + 1"};
+    std::vector<DatabaseParameter> parameters{json};
+
+    for (auto& it : get_listing_columns(table, json)) {
+        query += ", " + it.first + " = ?";
+        parameters.push_back(std::move(it.second));
+    }
+
+    query += " WHERE " + key + " = ?;";
+    parameters.emplace_back(value);
+
+    if (!db.exec(query, parameters)) {
+        return false;
+    }
+
+    touch_catalog(db, table);
+    return true;
+}
+
+bool ff::update_json_in_table(database& db, const std::string& table, const std::string& key, const std::string& value, const std::function<bool(nlohmann::json&)>& update) {
+    if (!db.good() || table.empty() || key.empty() || value.empty()) {
+        return false;
+    }
+
+    json_cache.erase(JsonCache::make_key(table, key, value));
+
+    // a write in between is noticed by the version changing, and the update is made again on top of it
+    constexpr int attempts{8};
+    for (int attempt{0}; attempt < attempts; ++attempt) {
+        const auto rows = db.query("SELECT id, version, json FROM " + table + " WHERE " + key + " = ?;", value);
+        if (rows.empty()) {
+            return false;
+        }
+
+        nlohmann::json json{};
+        try {
+            json = nlohmann::json::parse(rows.front().at("json"));
+        } catch (const std::exception&) {
+            return false;
+        }
+
+        if (!update(json)) {
+            return false;
+        }
+
+        const std::string dumped = json.dump();
+        std::string query{"UPDATE " + table + " SET json = ?, version = version + 1"};
+        std::vector<DatabaseParameter> parameters{dumped};
+
+        for (auto& it : get_listing_columns(table, dumped)) {
+            query += ", " + it.first + " = ?";
+            parameters.push_back(std::move(it.second));
+        }
+
+        query += " WHERE id = ? AND version = ?;";
+        parameters.emplace_back(std::stoll(rows.front().at("id")));
+        parameters.emplace_back(std::stoll(rows.front().at("version")));
+
+        if (!db.exec(query, parameters)) {
+            return false;
+        }
+        if (db.changes() > 0) {
+            touch_catalog(db, table);
+            return true;
+        }
+    }
+
+    ff::logger.write_to_log(limhamn::logger::type::warning, "Gave up updating " + table + " row " + value + " after " + std::to_string(attempts) + " conflicting writes.\n");
+    return false;
+}
+
+bool ff::patch_json_in_table(database& db, const std::string& table, const std::string& key, const std::string& value, const std::vector<JsonPatch>& patches) {
+    if (!db.good() || table.empty() || key.empty() || value.empty()) {
+        return false;
+    }
+
+    // the listing columns are derived from the whole document, so those tables are updated in full,
+    // and so are documents whose keys cannot be spelled in a SQLite JSON path
+    const bool in_database = table != "forwarders" && table != "sandbox" && table != "users" &&
+        std::none_of(patches.begin(), patches.end(), [](const JsonPatch& patch) {
+            return std::any_of(patch.path.begin(), patch.path.end(), [](const std::string& it) {
+                return it.find('"') != std::string::npos;
+            });
+        });
+    if (!in_database) {
+        return update_json_in_table(db, table, key, value, [&patches](nlohmann::json& json) -> bool {
+            for (const auto& it : patches) {
+                apply_json_patch(json, it);
+            }
+            return true;
+        });
+    }
+
+    json_cache.erase(JsonCache::make_key(table, key, value));
+
+    std::vector<DatabaseParameter> parameters{};
+    std::string expression{"json"};
+    for (const auto& it : patches) {
+        if (!it.path.empty()) {
+            expression = make_json_patch_expression(expression, it, db.is_postgres(), parameters);
+        }
+    }
+
+    parameters.emplace_back(value);
+    if (!db.exec("UPDATE " + table + " SET json = " + expression + ", version = version + 1 WHERE " + key + " = ?;", parameters)) {
+        return false;
+    }
+
+    return db.changes() > 0;
+}
+
+bool ff::insert_json_into_table(database& db, const std::string& table, const std::string& key, const std::string& value, const std::string& json) {
+    if (!db.good() || table.empty() || key.empty() || value.empty() || json.empty()) {
+        return false;
+    }
+
+    std::string columns{key + ", json"};
+    std::string placeholders{"?, ?"};
+    std::vector<DatabaseParameter> parameters{value, json};
+
+    for (auto& it : get_listing_columns(table, json)) {
+        columns += ", " + it.first;
+        placeholders += ", ?";
+        parameters.push_back(std::move(it.second));
+    }
+
+    if (!db.exec("INSERT INTO " + table + " (" + columns + ") VALUES (" + placeholders + ");", parameters)) {
+        return false;
+    }
+
+    if (table == "forwarders" || table == "sandbox") {
+        for (const auto& it : db.query("SELECT id FROM " + table + " WHERE " + key + " = ?;", value)) {
+            if (!link_item_files(db, table, std::stoll(it.at("id")), json)) {
+                logger.write_to_log(limhamn::logger::type::warning, "Failed to link the files of " + table + " row " + it.at("id") + ".\n");
+            }
+        }
+    }
+
+    touch_catalog(db, table);
+    return true;
+}
+
+/* Listings of forwarders and sandbox files are kept in memory (see ff::CatalogSnapshot),
+ * and every worker process checks the generation of the table before using its copy.
+ * Call this after any write that changes what those listings return; it does nothing
+ * for other tables. Inside a transaction, the bump commits with the write.
+ */
+void ff::touch_catalog(database& db, const std::string& table) {
+    if (table != "forwarders" && table != "sandbox") {
+        return;
+    }
+
+    if (!db.exec("UPDATE catalog_generations SET generation = generation + 1 WHERE kind = ?;", table)) {
+        logger.write_to_log(limhamn::logger::type::warning, "Failed to bump the catalog generation of " + table + ".\n");
+    }
+}
+
+int64_t ff::get_catalog_generation(database& db, const std::string& table) {
+    for (const auto& it : db.query("SELECT generation FROM catalog_generations WHERE kind = ?;", table)) {
+        return std::stoll(it.at("generation"));
+    }
+
+    throw std::runtime_error{"No catalog generation for " + table + "."};
+}
+
+/* Sets the rating a user gave a forwarder or sandbox file, or removes it if rating
+ * is 0, and moves the rating_sum, rating_count and rating columns of the upload by
+ * the difference in the same transaction, so listings never have to count ratings.
+ * Returns false if there is no such upload.
+ */
+bool ff::set_rating(database& db, const std::string& table, const std::string& identifier, const std::string& username, const int64_t rating) {
+    if (table != "forwarders" && table != "sandbox") {
+        throw std::runtime_error{"Only forwarders and sandbox files can be rated."};
+    }
+
+    // SQLite takes the write lock up front and PostgreSQL locks the row of the upload,
+    // so two ratings of the same upload never read the same previous state
+    if (!db.exec(db.is_postgres() ? "BEGIN;" : "BEGIN IMMEDIATE;")) {
+        throw std::runtime_error{"Failed to begin a transaction."};
+    }
+
+    try {
+        const auto item = db.query("SELECT id FROM " + table + " WHERE identifier = ?" + (db.is_postgres() ? " FOR UPDATE;" : ";"), identifier);
+        if (item.empty()) {
+            db.exec("ROLLBACK;");
+            return false;
+        }
+        const int64_t id = std::stoll(item.front().at("id"));
+
+        int64_t previous{0};
+        for (const auto& it : db.query("SELECT rating FROM ratings WHERE kind = ? AND identifier = ? AND username = ?;", table, identifier, username)) {
+            previous = std::stoll(it.at("rating"));
+        }
+
+        bool ok{};
+        if (rating == 0) {
+            ok = db.exec("DELETE FROM ratings WHERE kind = ? AND identifier = ? AND username = ?;", table, identifier, username);
+        } else {
+            ok = db.exec("INSERT INTO ratings (kind, identifier, username, rating) VALUES (?, ?, ?, ?) "
+                "ON CONFLICT (kind, identifier, username) DO UPDATE SET rating = excluded.rating;", table, identifier, username, rating);
+        }
+
+        const int64_t count = static_cast<int64_t>(rating != 0) - static_cast<int64_t>(previous != 0);
+        ok = ok && db.exec("UPDATE " + table + " SET rating_sum = rating_sum + ?, rating_count = rating_count + ? WHERE id = ?;", rating - previous, count, id);
+        ok = ok && db.exec("UPDATE " + table + " SET rating = CASE WHEN rating_count > 0 THEN rating_sum * 100 / rating_count ELSE 0 END WHERE id = ?;", id);
+        ok = ok && db.exec("UPDATE catalog_generations SET generation = generation + 1 WHERE kind = ?;", table);
+        ok = ok && db.exec("COMMIT;");
+
+        if (!ok) {
+            throw std::runtime_error{"Failed to rate " + table + " " + identifier};
+        }
+    } catch (const std::exception&) {
+        db.exec("ROLLBACK;");
+        throw;
+    }
+
+    return true;
+}
+
+/* Adds a comment to a forwarder or sandbox file and counts it in the comment_count
+ * column of the upload, in one transaction. Returns false if there is no such upload.
+ */
+bool ff::insert_comment(database& db, const std::string& table, const std::string& identifier, const std::string& username, const std::string& comment) {
+    if (table != "forwarders" && table != "sandbox") {
+        throw std::runtime_error{"Only forwarders and sandbox files can be commented on."};
+    }
+
+    const int64_t created_at = scrypto::return_unix_millis();
+    const nlohmann::json json{
+        {"comment", comment},
+        {"timestamp", created_at},
+        {"username", username},
+    };
+
+    if (!db.exec("BEGIN;")) {
+        throw std::runtime_error{"Failed to begin a transaction."};
+    }
+
+    try {
+        if (!db.exec("UPDATE " + table + " SET comment_count = comment_count + 1 WHERE identifier = ?;", identifier)) {
+            throw std::runtime_error{"Failed to comment on " + table + " " + identifier};
+        }
+        if (db.changes() == 0) {
+            db.exec("ROLLBACK;");
+            return false;
+        }
+
+        if (!db.exec("INSERT INTO comments (kind, identifier, username, created_at, json) VALUES (?, ?, ?, ?, ?);", table, identifier, username, created_at, json.dump()) ||
+            !db.exec("UPDATE catalog_generations SET generation = generation + 1 WHERE kind = ?;", table) ||
+            !db.exec("COMMIT;")) {
+            throw std::runtime_error{"Failed to comment on " + table + " " + identifier};
+        }
+    } catch (const std::exception&) {
+        db.exec("ROLLBACK;");
+        throw;
+    }
+
+    return true;
+}
+
+// returns false if the upload has no comment with that id
+bool ff::delete_comment(database& db, const std::string& table, const std::string& identifier, const int64_t id) {
+    if (table != "forwarders" && table != "sandbox") {
+        throw std::runtime_error{"Only forwarders and sandbox files can be commented on."};
+    }
+
+    if (!db.exec("BEGIN;")) {
+        throw std::runtime_error{"Failed to begin a transaction."};
+    }
+
+    try {
+        if (!db.exec("DELETE FROM comments WHERE id = ? AND kind = ? AND identifier = ?;", id, table, identifier)) {
+            throw std::runtime_error{"Failed to delete comment " + std::to_string(id)};
+        }
+        if (db.changes() == 0) {
+            db.exec("ROLLBACK;");
+            return false;
+        }
+
+        if (!db.exec("UPDATE " + table + " SET comment_count = comment_count - 1 WHERE identifier = ?;", identifier) ||
+            !db.exec("UPDATE catalog_generations SET generation = generation + 1 WHERE kind = ?;", table) ||
+            !db.exec("COMMIT;")) {
+            throw std::runtime_error{"Failed to delete comment " + std::to_string(id)};
+        }
+    } catch (const std::exception&) {
+        db.exec("ROLLBACK;");
+        throw;
+    }
+
+    return true;
 }
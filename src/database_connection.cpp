@@ -0,0 +1,319 @@
+#include <ff.hpp>
+#include <database.hpp>
+#include <metrics.hpp>
+
+namespace {
+#if FF_ENABLE_POSTGRESQL
+    // '?' placeholders become $1, $2, ...; anything inside a quoted string is left alone
+    std::string to_postgres_placeholders(const std::string& query) {
+        std::string ret{};
+        ret.reserve(query.size() + 16);
+
+        bool quoted{false};
+        std::size_t index{0};
+        for (const auto& c : query) {
+            if (c == '\'') {
+                quoted = !quoted;
+            }
+            if (c == '?' && !quoted) {
+                ret += "$" + std::to_string(++index);
+                continue;
+            }
+            ret += c;
+        }
+
+        return ret;
+    }
+
+    // PostgreSQL rejects text that is not valid UTF-8, so invalid bytes are dropped
+    std::string sanitize_utf8(const std::string& str) {
+        std::string ret{};
+        ret.reserve(str.size());
+
+        std::size_t i{0};
+        while (i < str.size()) {
+            const auto c = static_cast<unsigned char>(str[i]);
+            std::size_t length{0};
+            if (c < 0x80) {
+                length = 1;
+            } else if ((c & 0xE0) == 0xC0 && c >= 0xC2) {
+                length = 2;
+            } else if ((c & 0xF0) == 0xE0) {
+                length = 3;
+            } else if ((c & 0xF8) == 0xF0 && c <= 0xF4) {
+                length = 4;
+            }
+
+            bool valid = length != 0 && i + length <= str.size();
+            for (std::size_t j{1}; valid && j < length; ++j) {
+                valid = (static_cast<unsigned char>(str[i + j]) & 0xC0) == 0x80;
+            }
+
+            if (valid) {
+                ret.append(str, i, length);
+                i += length;
+            } else {
+                ++i;
+            }
+        }
+
+        return ret;
+    }
+#endif
+}
+
+ff::database::~database() {
+    for (auto& it : this->statements) {
+        this->finalize(it);
+    }
+#if FF_ENABLE_SQLITE
+    if (this->sqlite != nullptr) {
+        sqlite3_close_v2(this->sqlite);
+    }
+#endif
+#if FF_ENABLE_POSTGRESQL
+    if (this->postgres != nullptr) {
+        PQfinish(this->postgres);
+    }
+#endif
+}
+
+void ff::database::open_sqlite([[maybe_unused]] const std::string& file) {
+#if FF_ENABLE_SQLITE
+    // each connection is only ever used by one thread at a time
+    if (sqlite3_open_v2(file.c_str(), &this->sqlite, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX, nullptr) != SQLITE_OK) {
+        logger.write_to_log(limhamn::logger::type::error, "Failed to open SQLite database " + file + ": " + sqlite3_errmsg(this->sqlite) + "\n");
+        sqlite3_close_v2(this->sqlite);
+        this->sqlite = nullptr;
+    }
+#endif
+}
+
+void ff::database::open_postgres([[maybe_unused]] const std::string& host, [[maybe_unused]] const std::string& username,
+    [[maybe_unused]] const std::string& password, [[maybe_unused]] const std::string& database, [[maybe_unused]] const int port) {
+#if FF_ENABLE_POSTGRESQL
+    const std::string port_str = std::to_string(port);
+    const char* keywords[] = {"host", "user", "password", "dbname", "port", "client_encoding", nullptr};
+    const char* values[] = {host.c_str(), username.c_str(), password.c_str(), database.c_str(), port_str.c_str(), "UTF8", nullptr};
+
+    this->postgres = PQconnectdbParams(keywords, values, 0);
+    if (PQstatus(this->postgres) != CONNECTION_OK) {
+        logger.write_to_log(limhamn::logger::type::error, "Failed to connect to PostgreSQL: " + std::string{PQerrorMessage(this->postgres)} + "\n");
+        PQfinish(this->postgres);
+        this->postgres = nullptr;
+    }
+#endif
+}
+
+bool ff::database::good() const {
+#if FF_ENABLE_POSTGRESQL
+    if (this->enabled_type) {
+        return this->postgres != nullptr && PQstatus(this->postgres) == CONNECTION_OK;
+    }
+#endif
+#if FF_ENABLE_SQLITE
+    if (!this->enabled_type) {
+        return this->sqlite != nullptr;
+    }
+#endif
+    return false;
+}
+
+void ff::database::finalize([[maybe_unused]] Statement& statement) {
+#if FF_ENABLE_SQLITE
+    if (statement.sqlite != nullptr) {
+        sqlite3_finalize(statement.sqlite);
+        statement.sqlite = nullptr;
+    }
+#endif
+#if FF_ENABLE_POSTGRESQL
+    if (!statement.postgres.empty() && this->postgres != nullptr) {
+        PQclear(PQexec(this->postgres, ("DEALLOCATE " + statement.postgres).c_str()));
+        statement.postgres.clear();
+    }
+#endif
+}
+
+ff::database::Statement* ff::database::prepare(const std::string& query) {
+    if (const auto it = this->statement_index.find(query); it != this->statement_index.end()) {
+        this->statements.splice(this->statements.begin(), this->statements, it->second);
+        metrics.count_statement(true);
+        return &this->statements.front();
+    }
+
+    metrics.count_statement(false);
+
+    Statement statement{};
+    statement.sql = query;
+
+    if (!this->enabled_type) {
+#if FF_ENABLE_SQLITE
+        const char* tail{nullptr};
+        if (sqlite3_prepare_v3(this->sqlite, query.c_str(), static_cast<int>(query.size() + 1), SQLITE_PREPARE_PERSISTENT, &statement.sqlite, &tail) != SQLITE_OK) {
+            logger.write_to_log(limhamn::logger::type::warning, "Failed to prepare statement: " + query + ": " + sqlite3_errmsg(this->sqlite) + "\n");
+            return nullptr;
+        }
+        if (tail != nullptr && std::string_view{tail}.find_first_not_of(" \t\r\n;") != std::string_view::npos) {
+            logger.write_to_log(limhamn::logger::type::warning, "Only one SQL statement may be run at a time: " + query + "\n");
+            this->finalize(statement);
+            return nullptr;
+        }
+#endif
+    } else {
+#if FF_ENABLE_POSTGRESQL
+        statement.postgres = "ff_" + std::to_string(++this->statement_counter);
+
+        PGresult* result = PQprepare(this->postgres, statement.postgres.c_str(), to_postgres_placeholders(query).c_str(), 0, nullptr);
+        const bool ok = PQresultStatus(result) == PGRES_COMMAND_OK;
+        PQclear(result);
+
+        if (!ok) {
+            logger.write_to_log(limhamn::logger::type::warning, "Failed to prepare statement: " + query + ": " + PQerrorMessage(this->postgres));
+            return nullptr;
+        }
+#endif
+    }
+
+    // evict the least recently used statement once the cache is full
+    while (!this->statements.empty() && this->statements.size() >= std::max<std::size_t>(settings.database_statement_cache_size, 1)) {
+        this->statement_index.erase(this->statements.back().sql);
+        this->finalize(this->statements.back());
+        this->statements.pop_back();
+    }
+
+    this->statements.push_front(std::move(statement));
+    this->statement_index.emplace(this->statements.front().sql, this->statements.begin());
+
+    return &this->statements.front();
+}
+
+bool ff::database::run(const std::string& query, const std::vector<DatabaseParameter>& parameters, std::vector<std::unordered_map<std::string, std::string>>* rows) {
+    this->affected_rows = 0;
+
+    if (!this->good()) {
+        return false;
+    }
+
+    Statement* statement = this->prepare(query);
+    if (statement == nullptr) {
+        return false;
+    }
+
+    if (!this->enabled_type) {
+#if FF_ENABLE_SQLITE
+        sqlite3_stmt* stmt = statement->sqlite;
+
+        sqlite3_reset(stmt);
+        sqlite3_clear_bindings(stmt);
+
+        for (std::size_t i{0}; i < parameters.size(); ++i) {
+            const int index = static_cast<int>(i + 1);
+            if (std::holds_alternative<std::monostate>(parameters[i])) {
+                sqlite3_bind_null(stmt, index);
+            } else if (const auto* integer = std::get_if<int64_t>(&parameters[i])) {
+                sqlite3_bind_int64(stmt, index, *integer);
+            } else {
+                const auto& text = std::get<std::string>(parameters[i]);
+                sqlite3_bind_text(stmt, index, text.data(), static_cast<int>(text.size()), SQLITE_STATIC);
+            }
+        }
+
+        int status{SQLITE_OK};
+        while ((status = sqlite3_step(stmt)) == SQLITE_ROW) {
+            if (rows == nullptr) {
+                continue;
+            }
+
+            std::unordered_map<std::string, std::string> row{};
+            const int columns = sqlite3_column_count(stmt);
+            for (int i{0}; i < columns; ++i) {
+                const auto* text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, i));
+                row.emplace(sqlite3_column_name(stmt, i), text != nullptr ? std::string(text, static_cast<std::size_t>(sqlite3_column_bytes(stmt, i))) : "");
+            }
+            rows->push_back(std::move(row));
+        }
+
+        sqlite3_reset(stmt);
+        sqlite3_clear_bindings(stmt);
+
+        if (status != SQLITE_DONE) {
+            logger.write_to_log(limhamn::logger::type::warning, "Failed to run statement: " + query + ": " + sqlite3_errmsg(this->sqlite) + "\n");
+            return false;
+        }
+
+        if (rows == nullptr) {
+            this->affected_rows = static_cast<std::size_t>(sqlite3_changes(this->sqlite));
+        }
+        return true;
+#endif
+    } else {
+#if FF_ENABLE_POSTGRESQL
+        std::vector<std::string> values{};
+        std::vector<const char*> pointers{};
+        values.reserve(parameters.size());
+        pointers.reserve(parameters.size());
+
+        for (const auto& it : parameters) {
+            if (const auto* integer = std::get_if<int64_t>(&it)) {
+                values.push_back(std::to_string(*integer));
+            } else if (const auto* text = std::get_if<std::string>(&it)) {
+                values.push_back(sanitize_utf8(*text));
+            } else {
+                values.emplace_back();
+            }
+            pointers.push_back(std::holds_alternative<std::monostate>(it) ? nullptr : values.back().c_str());
+        }
+
+        const auto execute = [&]() -> PGresult* {
+            return PQexecPrepared(this->postgres, statement->postgres.c_str(), static_cast<int>(pointers.size()), pointers.data(), nullptr, nullptr, 0);
+        };
+
+        PGresult* result = execute();
+
+        // a cached plan is invalidated when an ALTER changes the result columns; prepare it again once
+        if (const char* state = PQresultErrorField(result, PG_DIAG_SQLSTATE); state != nullptr && std::string_view{state} == "0A000") {
+            PQclear(result);
+
+            this->statement_index.erase(statement->sql);
+            this->finalize(*statement);
+            this->statements.pop_front();
+
+            statement = this->prepare(query);
+            if (statement == nullptr) {
+                return false;
+            }
+            result = execute();
+        }
+
+        const auto status = PQresultStatus(result);
+        if (status != PGRES_TUPLES_OK && status != PGRES_COMMAND_OK) {
+            logger.write_to_log(limhamn::logger::type::warning, "Failed to run statement: " + query + ": " + PQresultErrorMessage(result));
+            PQclear(result);
+            return false;
+        }
+
+        if (rows != nullptr) {
+            const int row_count = PQntuples(result);
+            const int columns = PQnfields(result);
+            rows->reserve(static_cast<std::size_t>(row_count));
+
+            for (int i{0}; i < row_count; ++i) {
+                std::unordered_map<std::string, std::string> row{};
+                for (int j{0}; j < columns; ++j) {
+                    row.emplace(PQfname(result, j), PQgetisnull(result, i, j) ? "" : std::string(PQgetvalue(result, i, j), static_cast<std::size_t>(PQgetlength(result, i, j))));
+                }
+                rows->push_back(std::move(row));
+            }
+        }
+
+        if (const char* tuples = PQcmdTuples(result); tuples != nullptr && *tuples != '\0') {
+            this->affected_rows = std::stoul(tuples);
+        }
+
+        PQclear(result);
+        return true;
+#endif
+    }
+
+    return false;
+}
@@ -0,0 +1,141 @@
+#include <chrono>
+#include <unordered_map>
+#include <ff.hpp>
+#include <scrypto.hpp>
+#include <download_log.hpp>
+
+ff::DownloadLog::~DownloadLog() {
+    this->stop();
+}
+
+void ff::DownloadLog::start(std::unique_ptr<database> connection) {
+    {
+        std::lock_guard<std::mutex> lock{this->mutex};
+        if (this->running) {
+            return;
+        }
+        this->running = true;
+    }
+
+    this->db = std::move(connection);
+    this->writer = std::thread{&DownloadLog::run, this};
+}
+
+void ff::DownloadLog::stop() {
+    {
+        std::lock_guard<std::mutex> lock{this->mutex};
+        if (!this->running) {
+            return;
+        }
+        this->running = false;
+    }
+
+    this->condition.notify_one();
+    if (this->writer.joinable()) {
+        this->writer.join();
+    }
+    this->db.reset();
+}
+
+void ff::DownloadLog::push(const std::string& file_id, const UserProperties& properties) {
+    DownloadEvent event{
+        .file_id = file_id,
+        .username = properties.username.empty() ? "_nouser_" : properties.username,
+        .ip_address = properties.ip_address,
+        .user_agent = properties.user_agent,
+        .timestamp = scrypto::return_unix_millis(),
+    };
+
+    std::lock_guard<std::mutex> lock{this->mutex};
+    if (!this->running || this->events.size() >= settings.download_log_buffer_size) {
+        ++this->dropped;
+        return;
+    }
+
+    this->events.push_back(std::move(event));
+}
+
+void ff::DownloadLog::flush(std::vector<DownloadEvent>& batch) {
+    if (batch.empty()) {
+        return;
+    }
+
+    // many downloads of the same file in one batch become a single counter update
+    std::unordered_map<std::string, int64_t> counts{};
+    for (const auto& it : batch) {
+        ++counts[it.file_id];
+    }
+
+    const auto write = [&]() -> bool {
+        if (!this->db->exec("BEGIN;")) {
+            return false;
+        }
+
+        for (const auto& it : batch) {
+            if (!this->db->exec("INSERT INTO download_events (file_id, username, ip_address, user_agent, timestamp) VALUES (?, ?, ?, ?, ?);",
+                it.file_id, it.username, it.ip_address, it.user_agent, it.timestamp)) {
+                return false;
+            }
+        }
+        // the upload a file belongs to is counted too, since that is what the listings sort on
+        std::unordered_map<std::string, std::unordered_map<int64_t, int64_t>> items{};
+        for (const auto& [file_id, count] : counts) {
+            if (!this->db->exec("UPDATE files SET downloads = downloads + ? WHERE file_id = ?;", count, file_id)) {
+                return false;
+            }
+
+            for (const auto& it : this->db->query("SELECT item_kind, item_id FROM files WHERE file_id = ?;", file_id)) {
+                if ((it.at("item_kind") == "forwarders" || it.at("item_kind") == "sandbox") && !it.at("item_id").empty()) {
+                    items[it.at("item_kind")][std::stoll(it.at("item_id"))] += count;
+                }
+            }
+        }
+        for (const auto& [table, ids] : items) {
+            for (const auto& [id, count] : ids) {
+                if (!this->db->exec("UPDATE " + table + " SET downloads = downloads + ? WHERE id = ?;", count, id)) {
+                    return false;
+                }
+            }
+            touch_catalog(*this->db, table);
+        }
+
+        return this->db->exec("COMMIT;");
+    };
+
+    if (!write()) {
+        this->db->exec("ROLLBACK;");
+        logger.write_to_log(limhamn::logger::type::warning, "Failed to write " + std::to_string(batch.size()) + " download events.\n");
+    }
+
+    batch.clear();
+}
+
+void ff::DownloadLog::run() {
+    std::vector<DownloadEvent> batch{};
+
+    while (true) {
+        uint64_t dropped{0};
+        bool stopping{false};
+
+        {
+            std::unique_lock<std::mutex> lock{this->mutex};
+            this->condition.wait_for(lock, std::chrono::milliseconds{settings.download_log_flush_interval}, [this]() {
+                return !this->running;
+            });
+
+            batch.swap(this->events);
+            std::swap(dropped, this->dropped);
+            stopping = !this->running;
+        }
+
+        if (dropped > 0) {
+            logger.write_to_log(limhamn::logger::type::warning, "Dropped " + std::to_string(dropped) + " download events; the queue was full.\n");
+        }
+
+        this->flush(batch);
+
+        if (stopping) {
+            break;
+        }
+    }
+}
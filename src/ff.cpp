@@ -3,20 +3,30 @@
 #endif
 
 #include <algorithm>
+#include <thread>
+#include <chrono>
 #include <sstream>
+#include <fstream>
 #include <filesystem>
 #include <ff.hpp>
 #include <endpoint_handlers.hpp>
 #include <scrypto.hpp>
 #include <nlohmann/json.hpp>
 #include <limhamn/http/http_utils.hpp>
-#include <static_exists.hpp>
+#include <asset_bundle.hpp>
+#include <catalog.hpp>
+#include <router.hpp>
+#include <access_log.hpp>
+#include <download_log.hpp>
+#include <metrics.hpp>
+#include <worker_pool.hpp>
 
 void ff::print_help(const bool stream) {
     std::stringstream ss;
 
     ss << "ff-web [options]" << "\n";
     ss << "  -p, --port               Specify the port number to run ff-web on" << "\n";
+    ss << "  -w, --workers            Specify the number of worker processes to run" << "\n";
     ss << "  -c, --config-file        Specify the configuration file to use" << "\n";
     ss << "  -gc, --generate-config   Generate a default configuration file" << "\n";
     ss << "  -he, --halt-on-error     Halt the server on error" << "\n";
@@ -42,6 +52,22 @@ std::string ff::open_file(const std::string& file_path) {
     return content;
 }
 
+std::string ff::open_file(const std::string& file_path, const std::uintmax_t offset, const std::uintmax_t length) {
+    std::ifstream file{file_path, std::ios::binary};
+    if (!file.is_open()) {
+        throw std::runtime_error{"Failed to open file: " + file_path};
+    }
+
+    std::string content{};
+    content.resize(length);
+
+    file.seekg(static_cast<std::streamoff>(offset));
+    file.read(content.data(), static_cast<std::streamsize>(length));
+    content.resize(static_cast<std::size_t>(file.gcount()));
+
+    return content;
+}
+
 void ff::prepare_wd() {
     const auto log_error = [](const std::string& error_msg) {
         ff::logger.write_to_log(limhamn::logger::type::error, error_msg);
@@ -192,289 +218,250 @@ void ff::prepare_wd() {
 }
 
 void ff::start_server() {
-    try {
-#ifdef FF_ENABLE_SQLITE
-#ifndef FF_ENABLE_POSTGRESQL
-        settings.enabled_database = false;
-#endif
-#endif
-
-#ifdef FF_ENABLE_POSTGRESQL
-#ifndef FF_ENABLE_SQLITE
-        settings.enabled_database = true;
-#endif
-#endif
-
-#if FF_DEBUG
-        logger.write_to_log(limhamn::logger::type::notice, "Using database type: " + std::string(settings.enabled_database ? "PostgreSQL" : "SQLite") + "\n");
-#endif
-
-        std::shared_ptr<ff::database> database = std::make_shared<ff::database>(settings.enabled_database);
+    while (true) {
+        try {
+    #ifdef FF_ENABLE_SQLITE
+    #ifndef FF_ENABLE_POSTGRESQL
+            settings.enabled_database = false;
+    #endif
+    #endif
+
+    #ifdef FF_ENABLE_POSTGRESQL
+    #ifndef FF_ENABLE_SQLITE
+            settings.enabled_database = true;
+    #endif
+    #endif
+
+    #if FF_DEBUG
+            logger.write_to_log(limhamn::logger::type::notice, "Using database type: " + std::string(settings.enabled_database ? "PostgreSQL" : "SQLite") + "\n");
+    #endif
+
+            // one connection per worker; the first one also sets up the schema before the workers start
+            const std::size_t pool_size = settings.database_pool_size > 0 ? settings.database_pool_size : std::max(std::thread::hardware_concurrency(), 1U);
+
+            std::vector<std::unique_ptr<ff::database>> connections{};
+            connections.reserve(pool_size);
+            for (std::size_t i{0}; i < pool_size; ++i) {
+                connections.push_back(ff::open_database());
+            }
 
-        if (settings.enabled_database) {
-#ifdef FF_ENABLE_POSTGRESQL
-            database->get_postgres().open(settings.psql_host,
-                settings.psql_username,
-                settings.psql_password,
-                settings.psql_database,
-                settings.psql_port);
+            ff::database& database = *connections.front();
 
-#ifdef FF_DEBUG
-        	ff::logger.write_to_log(limhamn::logger::type::notice, "PostgreSQL database opened with host: " + settings.psql_host + ", username: " + settings.psql_username + ", password: " + settings.psql_password + ", database: " + settings.psql_database + "\n");
-#endif
-#endif
-        } else {
-#ifdef FF_ENABLE_SQLITE
-            database->get_sqlite().open(settings.sqlite_database_file);
-#endif
-        }
+            // workers of the supervisor find the database already set up, and must not migrate it concurrently
+            if (!ff::is_supervised_worker) {
+                setup_database(database);
+            }
 
-        if (!database->good()) {
-            ff::fatal = true;
-            throw std::runtime_error{"Error opening the database file."};
-        }
+            if (!ff::ensure_admin_account_exists(database)) {
+                ff::needs_setup = true;
+            }
 
-        setup_database(*database);
+            ff::asset_bundle.load();
 
-        if (!ff::ensure_admin_account_exists(*database)) {
-            ff::needs_setup = true;
-        }
+            // the catalogs are loaded up front so the first listings do not have to wait for them
+            try {
+                ff::forwarder_catalog.refresh(database);
+                ff::sandbox_catalog.refresh(database);
+            } catch (const std::exception& e) {
+                logger.write_to_log(limhamn::logger::type::error, "Failed to load the catalogs: " + std::string(e.what()) + "\n");
+            }
 
-        limhamn::http::server::server(limhamn::http::server::server_settings{
-            .port = settings.port,
-            .enable_session = true,
-            .session_directory = settings.session_directory,
-            .session_cookie_name = settings.session_cookie_name,
-            .associated_session_cookies = {
-                "username",
-                "user_type",
-            },
-            .max_request_size = settings.max_request_size,
-            .rate_limits = {},
-            .blacklisted_ips = settings.blacklisted_ips,
-            .whitelisted_ips = settings.whitelisted_ips,
-            .default_rate_limit = settings.rate_limit,
-            .trust_x_forwarded_for = settings.trust_x_forwarded_for,
-#ifndef FF_DEBUG
-        	.session_is_secure = true,
-#endif
-            }, [&](const limhamn::http::server::request& request) -> limhamn::http::server::response {
-            ff::logger.write_to_log(limhamn::logger::type::access, "Request received from " + request.ip_address + " to " + request.endpoint + " received, handling it.\n");
-
-            const std::unordered_map<std::string, std::function<limhamn::http::server::response(const limhamn::http::server::request&, ff::database&)>> handlers{
-                {virtual_favicon_path, ff::handle_virtual_favicon_endpoint},
-                {virtual_stylesheet_path, ff::handle_virtual_stylesheet_endpoint},
-                {virtual_script_path, ff::handle_virtual_script_endpoint},
-
-                {"/", ff::handle_root_endpoint},
-                {"/browse", ff::handle_root_endpoint},
-                {"/sandbox", ff::handle_root_endpoint},
-                {"/view", ff::handle_root_endpoint},
-                {"/post", ff::handle_root_endpoint},
-                {"/forum", ff::handle_root_endpoint},
-                {"/topic", ff::handle_root_endpoint},
-                {"/upload", ff::handle_root_endpoint},
-                {"/login", ff::handle_root_endpoint},
-                {"/register", ff::handle_root_endpoint},
-                {"/admin", ff::handle_root_endpoint},
-                {"/try_setup", ff::handle_try_setup_endpoint},
-
-                {"/api/try_upload_forwarder", ff::handle_try_upload_forwarder_endpoint},
-                {"/api/try_upload_file", ff::handle_try_upload_file_endpoint},
-                {"/api/try_login", ff::handle_api_try_login_endpoint},
-                {"/api/try_register", ff::handle_api_try_register_endpoint},
-                {"/api/get_forwarders", ff::handle_api_get_forwarders_endpoint},
-                {"/api/get_files", ff::handle_api_get_files_endpoint},
-                {"/api/set_approval_for_uploads", ff::handle_api_set_approval_for_uploads_endpoint},
-                {"/api/rate_forwarder", ff::handle_api_rate_forwarder_endpoint},
-                {"/api/rate_file", ff::handle_api_rate_file_endpoint},
-                {"/api/comment_forwarder", ff::handle_api_comment_forwarder_endpoint},
-                {"/api/comment_file", ff::handle_api_comment_file_endpoint},
-                {"/api/delete_comment_forwarder", ff::handle_api_delete_comment_forwarder_endpoint},
-                {"/api/delete_comment_file", ff::handle_api_delete_comment_file_endpoint},
-                {"/api/update_profile", ff::handle_api_update_profile_endpoint},
-                {"/api/get_profile", ff::handle_api_get_profile_endpoint},
-                {"/api/create_announcement", ff::handle_api_create_announcement_endpoint},
-                {"/api/get_announcements", ff::handle_api_get_announcements_endpoint},
-                {"/api/delete_announcement", ff::handle_api_delete_announcement},
-                {"/api/edit_announcement", ff::handle_api_edit_announcement_endpoint},
-                {"/api/stay_logged_in", ff::handle_api_stay_logged_in},
-                {"/api/try_logout", ff::handle_api_try_logout_endpoint},
-                {"/api/delete_forwarder", ff::handle_api_delete_forwarder_endpoint},
-                {"/api/delete_file", ff::handle_api_delete_file_endpoint},
-
-                {"/api/create_post", ff::handle_api_create_post_endpoint},
-                {"/api/delete_post", ff::handle_api_delete_post_endpoint},
-                {"/api/edit_post", ff::handle_api_edit_post_endpoint},
-                {"/api/close_post", ff::handle_api_close_post_endpoint},
-                {"/api/get_posts", ff::handle_api_get_posts_endpoint},
-                {"/api/comment_post", ff::handle_api_comment_post_endpoint},
-                {"/api/delete_comment_post", ff::handle_api_delete_comment_post_endpoint},
-                {"/api/create_topic", ff::handle_api_create_topic_endpoint},
-                {"/api/delete_topic", ff::handle_api_delete_topic_endpoint},
-                {"/api/get_topics", ff::handle_api_get_topics_endpoint},
-                {"/api/edit_topic", ff::handle_api_edit_topic_endpoint},
-                {"/api/close_topic", ff::handle_api_close_topic_endpoint},
-                //{"/api/pin_post_to_topic", ff::handle_api_pin_post_to_topic},
+            ff::access_log.start();
+            ff::download_log.start(ff::open_database());
+
+            ff::WorkerPool worker_pool{std::move(connections)};
+
+            // built once; the request handler only looks up endpoints in these
+            static const ff::Router router{
+                {
+                    {virtual_favicon_path, ff::handle_virtual_favicon_endpoint},
+                    {virtual_stylesheet_path, ff::handle_virtual_stylesheet_endpoint},
+                    {virtual_script_path, ff::handle_virtual_script_endpoint},
+
+                    {"/", ff::handle_root_endpoint},
+                    {"/browse", ff::handle_root_endpoint},
+                    {"/sandbox", ff::handle_root_endpoint},
+                    {"/view", ff::handle_root_endpoint},
+                    {"/post", ff::handle_root_endpoint},
+                    {"/forum", ff::handle_root_endpoint},
+                    {"/topic", ff::handle_root_endpoint},
+                    {"/upload", ff::handle_root_endpoint},
+                    {"/login", ff::handle_root_endpoint},
+                    {"/register", ff::handle_root_endpoint},
+                    {"/admin", ff::handle_root_endpoint},
+                    {"/try_setup", ff::handle_try_setup_endpoint},
+
+                    {"/api/try_upload_forwarder", ff::handle_try_upload_forwarder_endpoint},
+                    {"/api/try_upload_file", ff::handle_try_upload_file_endpoint},
+                    {"/api/try_login", ff::handle_api_try_login_endpoint},
+                    {"/api/try_register", ff::handle_api_try_register_endpoint},
+                    {"/api/get_forwarders", ff::handle_api_get_forwarders_endpoint},
+                    {"/api/get_files", ff::handle_api_get_files_endpoint},
+                    {"/api/set_approval_for_uploads", ff::handle_api_set_approval_for_uploads_endpoint},
+                    {"/api/rate_forwarder", ff::handle_api_rate_forwarder_endpoint},
+                    {"/api/rate_file", ff::handle_api_rate_file_endpoint},
+                    {"/api/comment_forwarder", ff::handle_api_comment_forwarder_endpoint},
+                    {"/api/comment_file", ff::handle_api_comment_file_endpoint},
+                    {"/api/delete_comment_forwarder", ff::handle_api_delete_comment_forwarder_endpoint},
+                    {"/api/delete_comment_file", ff::handle_api_delete_comment_file_endpoint},
+                    {"/api/get_comments", ff::handle_api_get_comments_endpoint},
+                    {"/api/update_profile", ff::handle_api_update_profile_endpoint},
+                    {"/api/get_profile", ff::handle_api_get_profile_endpoint},
+                    {"/api/create_announcement", ff::handle_api_create_announcement_endpoint},
+                    {"/api/get_announcements", ff::handle_api_get_announcements_endpoint},
+                    {"/api/delete_announcement", ff::handle_api_delete_announcement},
+                    {"/api/edit_announcement", ff::handle_api_edit_announcement_endpoint},
+                    {"/api/stay_logged_in", ff::handle_api_stay_logged_in},
+                    {"/api/try_logout", ff::handle_api_try_logout_endpoint},
+                    {"/api/delete_forwarder", ff::handle_api_delete_forwarder_endpoint},
+                    {"/api/delete_file", ff::handle_api_delete_file_endpoint},
+
+                    {"/api/create_post", ff::handle_api_create_post_endpoint},
+                    {"/api/delete_post", ff::handle_api_delete_post_endpoint},
+                    {"/api/edit_post", ff::handle_api_edit_post_endpoint},
+                    {"/api/close_post", ff::handle_api_close_post_endpoint},
+                    {"/api/get_posts", ff::handle_api_get_posts_endpoint},
+                    {"/api/comment_post", ff::handle_api_comment_post_endpoint},
+                    {"/api/delete_comment_post", ff::handle_api_delete_comment_post_endpoint},
+                    {"/api/create_topic", ff::handle_api_create_topic_endpoint},
+                    {"/api/delete_topic", ff::handle_api_delete_topic_endpoint},
+                    {"/api/get_topics", ff::handle_api_get_topics_endpoint},
+                    {"/api/edit_topic", ff::handle_api_edit_topic_endpoint},
+                    {"/api/close_topic", ff::handle_api_close_topic_endpoint},
+                    {"/metrics", ff::handle_metrics_endpoint},
+                    //{"/api/pin_post_to_topic", ff::handle_api_pin_post_to_topic},
+                },
+                {
+                    {"/download/", ff::handle_download_endpoint},
+                    {"/activate/", ff::handle_activate_endpoint},
+                    {"/view/", ff::handle_root_endpoint},
+                    {"/file/", ff::handle_root_endpoint},
+                    {"/profile/", ff::handle_root_endpoint},
+                    {"/topic/", ff::handle_root_endpoint},
+                    {"/post/", ff::handle_root_endpoint},
+                },
+                ff::handle_not_found_endpoint,
             };
-            const std::unordered_map<std::string, std::function<limhamn::http::server::response(const limhamn::http::server::request&, ff::database&)>> setup_handlers{
-                {virtual_favicon_path, ff::handle_virtual_favicon_endpoint},
-                {virtual_stylesheet_path, ff::handle_virtual_stylesheet_endpoint},
-                {virtual_script_path, ff::handle_virtual_script_endpoint},
-                {"/try_setup", ff::handle_try_setup_endpoint},
-                {"/setup", ff::handle_setup_endpoint}
+            static const ff::Router setup_router{
+                {
+                    {virtual_favicon_path, ff::handle_virtual_favicon_endpoint},
+                    {virtual_stylesheet_path, ff::handle_virtual_stylesheet_endpoint},
+                    {virtual_script_path, ff::handle_virtual_script_endpoint},
+                    {"/try_setup", ff::handle_try_setup_endpoint},
+                    {"/setup", ff::handle_setup_endpoint},
+                },
+                {},
+                ff::handle_setup_endpoint,
             };
-
-            // handle custom paths
-            for (const auto& it : ff::settings.custom_paths) {
-                if (it.first == request.endpoint) {
-                    limhamn::http::server::response response{};
-
-                    if (!ff::static_exists.is_file(it.second)) {
-                        response.content_type = "text/html";
-                        response.http_status = 404;
-                        response.body = "<p>404 Not Found</p>";
-
-                        return response;
+            static const std::size_t static_route_id = ff::metrics.register_route("static");
+
+            limhamn::http::server::server(limhamn::http::server::server_settings{
+                .port = settings.port,
+                .enable_session = true,
+                .session_directory = settings.session_directory,
+                .session_cookie_name = settings.session_cookie_name,
+                .associated_session_cookies = {
+                    "username",
+                    "user_type",
+                },
+                .max_request_size = settings.max_request_size,
+                .rate_limits = {},
+                .blacklisted_ips = settings.blacklisted_ips,
+                .whitelisted_ips = settings.whitelisted_ips,
+                .default_rate_limit = settings.rate_limit,
+                .trust_x_forwarded_for = settings.trust_x_forwarded_for,
+    #ifndef FF_DEBUG
+            	.session_is_secure = true,
+    #endif
+                }, [&](const limhamn::http::server::request& request) -> limhamn::http::server::response {
+                const auto start = std::chrono::steady_clock::now();
+                std::size_t metrics_id{static_route_id};
+
+                ff::metrics.begin_request();
+
+                const auto handle = [&]() -> limhamn::http::server::response {
+                    if (const auto asset = ff::asset_bundle.find(request.endpoint); asset != nullptr) {
+                        return ff::asset_bundle.serve(request, *asset);
                     }
 
-                    response.body = ff::cache_manager.open_file(it.second);
-                    response.http_status = 200;
-                    response.content_type = limhamn::http::utils::get_appropriate_content_type(it.first);
-
-                    return response;
+                    return worker_pool.dispatch([&](ff::database& db) {
+                        // setup may have finished on another worker
+                        const auto& route = ff::needs_setup && ff::check_needs_setup(db) ? setup_router.find(request.endpoint) : router.find(request.endpoint);
+                        metrics_id = route.metrics_id;
+
+                        return route.handler(request, db);
+                    });
+                };
+
+                const auto record = [&](const int status) {
+                    const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+                    ff::access_log.push(request, status, duration.count());
+                    ff::metrics.end_request(metrics_id, status, duration.count());
+                };
+
+                limhamn::http::server::response response{};
+                try {
+                    response = handle();
+                } catch (...) {
+                    // still log the request and close it in the metrics, or in_flight never drops
+                    record(500);
+                    throw;
                 }
-            }
 
-            if (needs_setup && setup_handlers.find(request.endpoint) != setup_handlers.end()) {
-                return setup_handlers.at(request.endpoint)(request, *database);
-            } else if (needs_setup) {
-                return setup_handlers.at("/setup")(request, *database);
-            }
+                record(response.http_status);
 
-            if (handlers.find(request.endpoint) != handlers.end()) {
-                return handlers.at(request.endpoint)(request, *database);
-            }
+                return response;
+            });
 
-            // check if a file upload exists and if so, download and serve
-            std::string file = request.endpoint;
+            return;
+        } catch (const std::exception& e) {
+            ff::logger.write_to_log(limhamn::logger::type::error, "An error occurred: " + std::string{e.what()} + "\n");
 
-            if (file.back() == '/') {
-                file.pop_back();
+            // a little bit ugly but whatever
+            if (std::string(e.what()).find("Address already in use") != std::string::npos) {
+                ff::fatal = true;
             }
 
-            if (file.find("/download/") != std::string::npos) {
-                std::filesystem::path file_path = file.substr(10); // remove /download/
-                file_path = file_path.lexically_normal(); // normalize the path
-
-                if (ff::is_file(*database, file_path.string())) {
-                    const auto& h = ff::download_file(*database, ff::UserProperties{
-                        .username = request.session.find("username") != request.session.end() ? request.session.at("username") : "",
-                        .ip_address = request.ip_address,
-                        .user_agent = request.user_agent,
-                    }, file_path.string());
-
-#if FF_DEBUG
-                    logger.write_to_log(limhamn::logger::type::notice, "File download request for: " + h.path + "\n");
-#endif
-
-                    limhamn::http::server::response response{};
-
-                    response.body = open_file(h.path);
-                    response.http_status = 200;
-                    response.content_type = limhamn::http::utils::get_appropriate_content_type(h.name);
-
-                    if (settings.preview_files) {
-                        response.headers.push_back({"Content-Disposition", "inline; filename=\"" + h.name + "\""});
-                    } else {
-                        response.headers.push_back({"Content-Disposition", "attachment; filename=\"" + h.name + "\""});
-                    }
-
-                    return response;
-                }
-            } else if (file.find("/view/") != std::string::npos) {
-                std::filesystem::path file_path = file;
-                file_path = file_path.lexically_normal(); // normalize the path
-
-                if (file_path.string().find("/view/") == 0) {
-                    return handlers.at("/")(request, *database);
-                }
-            } else if (file.find("/file/") != std::string::npos) {
-                return handlers.at("/")(request, *database);
-            } else if (file.find("/profile/") != std::string::npos) {
-                return handlers.at("/")(request, *database);
-            } else if (file.find("/topic") != std::string::npos) {
-                return handlers.at("/")(request, *database);
-            } else if (file.find("/post/") != std::string::npos) {
-                return handlers.at("/")(request, *database);
+        	if (std::string(e.what()).find("Error creating the ") != std::string::npos) {
+                ff::fatal = true;
             }
 
-            // handle activation URLs
-            if (file.find("/activate/") != std::string::npos && settings.enable_email_verification) {
-                const auto& list = database->query("SELECT * FROM activation_urls WHERE url = ?;", file);
-                for (const auto& it : list) {
-                    try {
-                        const auto json = get_json_from_table(*database, "users", "username", it.at("username"));
-                        nlohmann::json user_json;
-                        try {
-                            user_json = nlohmann::json::parse(json);
-                        } catch (const std::exception&) {
-                            break;
-                        }
-
-                        user_json["activated"] = true;
-
-                        set_json_in_table(*database, "users", "username", it.at("username"), user_json.dump());
-
-                        database->exec("DELETE FROM activation_urls WHERE url = ?;", file);
-
-                        // redirect to /
-                        limhamn::http::server::response response{};
-                        response.http_status = 302;
-                        response.headers.push_back({"Location", "/"});
-                        return response;
-                    } catch (const std::exception&) {
-                        limhamn::http::server::response resp;
-                        resp.content_type = "text/html";
-                        resp.http_status = 500;
-                        resp.body = "<p>500 Internal Server Error</p>";
-                        return resp;
-                    }
-                }
+            if (ff::fatal) {
+                ff::logger.write_to_log(limhamn::logger::type::error, "The last error was too severe to recover, and the server will now halt.\n");
+                std::exit(EXIT_FAILURE);
             }
 
-            limhamn::http::server::response response{};
-
-            response.content_type = "text/html";
-            response.http_status = 404;
-            response.body = "<p>404 Not Found</p>";
-
-            return response;
-        });
-    } catch (const std::exception& e) {
-        ff::logger.write_to_log(limhamn::logger::type::error, "An error occurred: " + std::string{e.what()} + "\n");
+            if (ff::settings.halt_on_error) {
+                ff::logger.write_to_log(limhamn::logger::type::error, "Halting the server due to an error.\n");
+                std::exit(EXIT_FAILURE);
+            }
 
-        // a little bit ugly but whatever
-        if (std::string(e.what()).find("Address already in use") != std::string::npos) {
-            ff::fatal = true;
+            // start over in place; the server is restarted by this loop, not by recursing
+            std::this_thread::sleep_for(std::chrono::seconds{1});
         }
+    }
+}
 
-    	if (std::string(e.what()).find("Error creating the ") != std::string::npos) {
-            ff::fatal = true;
+std::string ff::get_header(const limhamn::http::server::request& request, const std::string& name) {
+    for (const auto& [key, value] : request.headers) {
+        if (key.size() == name.size() && std::equal(key.begin(), key.end(), name.begin(), [](const char a, const char b) {
+            return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+        })) {
+            return value;
         }
+    }
 
-        if (ff::fatal) {
-            ff::logger.write_to_log(limhamn::logger::type::error, "The last error was too severe to recover, and the server will now halt.\n");
-            std::exit(EXIT_FAILURE);
-        }
+    return "";
+}
 
-        if (ff::settings.halt_on_error) {
-            ff::logger.write_to_log(limhamn::logger::type::error, "Halting the server due to an error.\n");
-            std::exit(EXIT_FAILURE);
-        }
+std::string ff::http_date(const std::time_t time) {
+    std::tm tm{};
+    gmtime_r(&time, &tm);
 
-        start_server();
-    }
+    char buf[64];
+    std::strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+
+    return buf;
 }
 
 std::string ff::get_temp_path() {
@@ -0,0 +1,75 @@
+#include <ff.hpp>
+#include <json_cache.hpp>
+
+namespace {
+    // a parsed document takes several times the memory of its text
+    constexpr std::size_t json_cache_overhead{4};
+}
+
+std::string ff::JsonCache::make_key(const std::string& table, const std::string& key, const std::string& value) {
+    std::string ret{};
+    ret.reserve(table.size() + key.size() + value.size() + 2);
+    ret += table;
+    ret += '\0';
+    ret += key;
+    ret += '\0';
+    ret += value;
+    return ret;
+}
+
+ff::CachedJson ff::JsonCache::find(const std::string& key) {
+    std::lock_guard<std::mutex> lock{this->mutex};
+
+    const auto it = this->index.find(key);
+    if (it == this->index.end()) {
+        return {};
+    }
+
+    this->entries.splice(this->entries.begin(), this->entries, it->second);
+    return it->second->document;
+}
+
+void ff::JsonCache::insert(const std::string& key, const CachedJson& document, const std::size_t size) {
+    const std::size_t cost = size * json_cache_overhead + key.size();
+    if (cost > settings.json_cache_size) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock{this->mutex};
+
+    if (const auto it = this->index.find(key); it != this->index.end()) {
+        this->used -= it->second->cost;
+        this->entries.erase(it->second);
+        this->index.erase(it);
+    }
+
+    while (!this->entries.empty() && this->used + cost > settings.json_cache_size) {
+        this->used -= this->entries.back().cost;
+        this->index.erase(this->entries.back().key);
+        this->entries.pop_back();
+    }
+
+    this->entries.push_front(Entry{key, document, cost});
+    this->index.emplace(key, this->entries.begin());
+    this->used += cost;
+}
+
+void ff::JsonCache::erase(const std::string& key) {
+    std::lock_guard<std::mutex> lock{this->mutex};
+
+    if (const auto it = this->index.find(key); it != this->index.end()) {
+        this->used -= it->second->cost;
+        this->entries.erase(it->second);
+        this->index.erase(it);
+    }
+}
+
+std::shared_ptr<const nlohmann::json> ff::JsonCache::parse(const std::string& key, const int64_t id, const int64_t version, const std::string& text) {
+    if (const auto cached = this->find(key); cached.json != nullptr && cached.id == id && cached.version == version) {
+        return cached.json;
+    }
+
+    auto json = std::make_shared<const nlohmann::json>(nlohmann::json::parse(text));
+    this->insert(key, CachedJson{id, version, json}, text.size());
+    return json;
+}
@@ -0,0 +1,184 @@
+#include <algorithm>
+#include <listing_filter.hpp>
+
+namespace {
+    std::string to_lower(std::string str) {
+        std::transform(str.begin(), str.end(), str.begin(), ::tolower);
+        return str;
+    }
+}
+
+ff::ListingDocument ff::get_listing_document(const nlohmann::json& json) {
+    ListingDocument document{};
+
+    if (!json.is_object() || json.find("meta") == json.end()) {
+        return document;
+    }
+
+    document.listed = true;
+
+    const auto& meta = json.at("meta");
+    if (meta.is_object() && meta.find("categories") != meta.end() && meta.at("categories").is_array()) {
+        for (const auto& category : meta.at("categories")) {
+            if (category.is_string()) {
+                document.categories.push_back(to_lower(category.get<std::string>()));
+            }
+        }
+    }
+    if (meta.is_object() && meta.find("filename") != meta.end() && meta.at("filename").is_string()) {
+        document.filename = to_lower(meta.at("filename").get<std::string>());
+    }
+
+    return document;
+}
+
+std::string ff::ListingFilter::get_where(std::vector<DatabaseParameter>& parameters) const {
+    std::string where{};
+
+    const auto add_condition = [&](const std::string& condition) -> void {
+        where += (where.empty() ? " WHERE " : " AND ") + condition;
+    };
+    const auto add_text = [&](const std::string& column, const std::string& value) -> void {
+        if (!value.empty()) {
+            add_condition(column + " = ?");
+            parameters.emplace_back(value);
+        }
+    };
+
+    add_text("identifier", this->identifier);
+    if (this->accepted) {
+        add_condition("needs_review = 0");
+    }
+    if (this->needs_review) {
+        add_condition("needs_review = 1");
+    }
+    add_text("uploader", this->uploader);
+    add_text("author", this->author);
+    add_text("location", this->location);
+    add_text("title_id", this->title_id);
+    add_text("title", this->title);
+    if (this->type != -1) {
+        add_condition("type = ?");
+        parameters.emplace_back(static_cast<int64_t>(this->type));
+    }
+    if (this->vwii != -1) {
+        add_condition("vwii_compatible = ?");
+        parameters.emplace_back(static_cast<int64_t>(this->vwii));
+    }
+    if (this->has_submitted) {
+        add_condition("submitted BETWEEN ? AND ?");
+        parameters.emplace_back(this->submitted_from);
+        parameters.emplace_back(this->submitted_to);
+    }
+
+    return where;
+}
+
+bool ff::ListingFilter::matches(const ListingDocument& document) const {
+    if (!document.listed) {
+        return false;
+    }
+
+    if (!this->filename.empty() && !document.filename.empty() && document.filename != this->filename) {
+        return false;
+    }
+
+    if (!this->categories.empty()) {
+        return std::any_of(this->categories.begin(), this->categories.end(), [&](const std::string& category) {
+            return std::find(document.categories.begin(), document.categories.end(), category) != document.categories.end();
+        });
+    }
+
+    return true;
+}
+
+bool ff::ListingFilter::is_default_browse() const {
+    return this->accepted && !this->needs_review && this->search_string.empty() && this->identifier.empty() &&
+        this->uploader.empty() && this->author.empty() && this->location.empty() && this->title_id.empty() &&
+        this->title.empty() && this->filename.empty() && this->type == -1 && this->vwii == -1 &&
+        !this->has_submitted && this->categories.empty() && this->begin <= 0 && this->end == -1;
+}
+
+ff::ListingFilter ff::parse_listing_filter(const nlohmann::json& filter, const std::string& table) {
+    ListingFilter ret{};
+
+    if (!filter.is_object()) {
+        return ret;
+    }
+
+    const bool forwarders = table == "forwarders";
+
+    const auto get_bool = [&](const std::string& key, bool& value) -> void {
+        if (filter.find(key) != filter.end() && filter.at(key).is_boolean()) {
+            value = filter.at(key).get<bool>();
+        }
+    };
+    const auto get_string = [&](const std::string& key, std::string& value) -> void {
+        if (filter.find(key) != filter.end() && filter.at(key).is_string()) {
+            value = filter.at(key).get<std::string>();
+        }
+    };
+    const auto get_int = [&](const std::string& key, int& value) -> void {
+        if (filter.find(key) != filter.end() && filter.at(key).is_number_integer()) {
+            value = filter.at(key).get<int>();
+        }
+    };
+
+    get_bool("accepted", ret.accepted);
+    get_bool("needs_review", ret.needs_review);
+    get_string("search_string", ret.search_string);
+    get_string("identifier", ret.identifier);
+    get_string("uploader", ret.uploader);
+    get_string("author", ret.author);
+    if (forwarders) {
+        get_string("location", ret.location);
+        get_string("title_id_string", ret.title_id);
+        get_int("type", ret.type);
+        get_int("vwii", ret.vwii);
+    } else {
+        get_string("title", ret.title);
+        get_string("filename", ret.filename);
+    }
+    get_int("begin", ret.begin);
+    get_int("end", ret.end);
+
+    for (auto* it : {&ret.uploader, &ret.author, &ret.location, &ret.title_id, &ret.title, &ret.filename}) {
+        *it = to_lower(*it);
+    }
+    if (ret.type != 0 && ret.type != 1) {
+        ret.type = -1;
+    }
+    if (ret.vwii != 0 && ret.vwii != 1) {
+        ret.vwii = -1;
+    }
+
+    if (filter.find("categories") != filter.end() && filter.at("categories").is_array()) {
+        for (const auto& it : filter.at("categories")) {
+            if (it.is_string()) {
+                ret.categories.push_back(it.get<std::string>());
+            }
+        }
+    }
+
+    // before, after and between narrow the same range; -1 leaves a bound unset
+    const auto narrow = [&](const int64_t from, const int64_t to) -> void {
+        ret.has_submitted = true;
+        ret.submitted_from = std::max(ret.submitted_from, from);
+        ret.submitted_to = std::min(ret.submitted_to, to);
+    };
+    if (filter.find("submitted_before") != filter.end() && filter.at("submitted_before").is_number_integer() && filter.at("submitted_before").get<int64_t>() != -1) {
+        narrow(std::numeric_limits<int64_t>::min(), filter.at("submitted_before").get<int64_t>());
+    }
+    if (filter.find("submitted_after") != filter.end() && filter.at("submitted_after").is_number_integer() && filter.at("submitted_after").get<int64_t>() != -1) {
+        narrow(filter.at("submitted_after").get<int64_t>(), std::numeric_limits<int64_t>::max());
+    }
+    if (filter.find("submitted_between") != filter.end() && filter.at("submitted_between").is_array() && filter.at("submitted_between").size() == 2) {
+        const auto& between = filter.at("submitted_between");
+        if (between.at(0).is_number_integer() && between.at(1).is_number_integer() &&
+            between.at(0).get<int64_t>() != -1 && between.at(1).get<int64_t>() != -1) {
+            narrow(between.at(0).get<int64_t>(), between.at(1).get<int64_t>());
+        }
+    }
+
+    return ret;
+}
@@ -34,6 +34,14 @@ int main(int argc, char** argv) {
 
         ff::settings.port = std::stoi(c.arguments.at(++c.index));
     });
+    arg.push_back("-w|--workers|/w|/workers", [&](limhamn::argument_manager::collection& c) {
+        if (c.arguments.size() <= 1) {
+            std::cerr << "The -w/--workers flag requires a number of workers to be specified.\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+        ff::settings.workers = std::stoul(c.arguments.at(++c.index));
+    });
     arg.push_back("-he|--halt-on-error|/he|/halt-on-error", [&](const limhamn::argument_manager::collection&) {ff::settings.halt_on_error = true;});
     arg.push_back("-nhe|--no-halt-on-error|/nhe|/no-halt-on-error", [&](const limhamn::argument_manager::collection&) {ff::settings.halt_on_error = false;});
     arg.push_back("-c|--config-file|/c|/config-file", [&](limhamn::argument_manager::collection& c) {
@@ -65,6 +73,11 @@ int main(int argc, char** argv) {
 #endif
 
     ff::prepare_wd();
+
+    if (ff::settings.workers > 1) {
+        ff::run_supervisor(ff::settings.workers);
+    }
+
     ff::start_server();
 
     return EXIT_SUCCESS;
@@ -0,0 +1,275 @@
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <metrics.hpp>
+
+namespace {
+    std::size_t get_status_slot(const int http_status) {
+        for (std::size_t i{0}; i < ff::metrics_status_codes.size(); ++i) {
+            if (ff::metrics_status_codes[i] == http_status) {
+                return i;
+            }
+        }
+
+        const int status_class = std::clamp(http_status / 100, 1, 5);
+        return ff::metrics_status_codes.size() + static_cast<std::size_t>(status_class - 1);
+    }
+
+    std::string get_status_label(const std::size_t slot) {
+        if (slot < ff::metrics_status_codes.size()) {
+            return std::to_string(ff::metrics_status_codes[slot]);
+        }
+        return std::to_string(slot - ff::metrics_status_codes.size() + 1) + "xx";
+    }
+
+    // written by the owning thread only, so no read-modify-write is needed
+    template <typename T>
+    void increment(std::atomic<T>& counter, const T value) {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    std::string escape_label(const std::string& label) {
+        std::string ret{};
+        ret.reserve(label.size());
+        for (const auto& c : label) {
+            if (c == '\\' || c == '"') {
+                ret += '\\';
+                ret += c;
+            } else if (c == '\n') {
+                ret += "\\n";
+            } else {
+                ret += c;
+            }
+        }
+        return ret;
+    }
+
+    void write_histogram(std::ostringstream& ss, const std::string& name, const std::string& labels, const ff::Histogram& histogram) {
+        const std::string prefix = labels.empty() ? "" : labels + ",";
+
+        uint64_t cumulative{0};
+        for (std::size_t i{0}; i < ff::metrics_buckets.size(); ++i) {
+            cumulative += histogram.buckets[i].load(std::memory_order_relaxed);
+            ss << name << "_bucket{" << prefix << "le=\"" << static_cast<double>(ff::metrics_buckets[i]) / 1e6 << "\"} " << cumulative << "\n";
+        }
+        cumulative += histogram.buckets.back().load(std::memory_order_relaxed);
+        ss << name << "_bucket{" << prefix << "le=\"+Inf\"} " << cumulative << "\n";
+
+        const std::string braced = labels.empty() ? "" : "{" + labels + "}";
+        ss << name << "_sum" << braced << " " << static_cast<double>(histogram.sum.load(std::memory_order_relaxed)) / 1e6 << "\n";
+        ss << name << "_count" << braced << " " << cumulative << "\n";
+    }
+}
+
+void ff::Histogram::observe(const int64_t duration) {
+    const auto it = std::lower_bound(metrics_buckets.begin(), metrics_buckets.end(), duration);
+    increment(this->buckets[static_cast<std::size_t>(it - metrics_buckets.begin())], uint64_t{1});
+    increment(this->sum, static_cast<uint64_t>(std::max<int64_t>(duration, 0)));
+}
+
+void ff::Histogram::merge(const Histogram& histogram) {
+    for (std::size_t i{0}; i < this->buckets.size(); ++i) {
+        increment(this->buckets[i], histogram.buckets[i].load(std::memory_order_relaxed));
+    }
+    increment(this->sum, histogram.sum.load(std::memory_order_relaxed));
+}
+
+uint64_t ff::Histogram::count() const {
+    uint64_t count{0};
+    for (const auto& it : this->buckets) {
+        count += it.load(std::memory_order_relaxed);
+    }
+    return count;
+}
+
+ff::MetricsShard::MetricsShard() : requests(std::make_unique<std::atomic<Histogram*>[]>(metrics_max_routes * metrics_status_slots)) {
+    for (std::size_t i{0}; i < metrics_max_routes * metrics_status_slots; ++i) {
+        this->requests[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+ff::MetricsShard::~MetricsShard() {
+    for (std::size_t i{0}; i < metrics_max_routes * metrics_status_slots; ++i) {
+        delete this->requests[i].load(std::memory_order_relaxed);
+    }
+}
+
+ff::Histogram& ff::MetricsShard::get_request(const std::size_t route, const std::size_t status_slot) {
+    auto& cell = this->requests[route * metrics_status_slots + status_slot];
+
+    Histogram* histogram = cell.load(std::memory_order_relaxed);
+    if (histogram == nullptr) {
+        histogram = new Histogram{};
+        cell.store(histogram, std::memory_order_release);
+    }
+
+    return *histogram;
+}
+
+void ff::MetricsShard::merge(const MetricsShard& shard) {
+    for (std::size_t i{0}; i < metrics_max_routes * metrics_status_slots; ++i) {
+        if (const Histogram* histogram = shard.requests[i].load(std::memory_order_acquire); histogram != nullptr) {
+            this->get_request(i / metrics_status_slots, i % metrics_status_slots).merge(*histogram);
+        }
+    }
+    for (std::size_t i{0}; i < this->database.size(); ++i) {
+        this->database[i].merge(shard.database[i]);
+    }
+    for (std::size_t i{0}; i < this->uploads.size(); ++i) {
+        this->uploads[i].merge(shard.uploads[i]);
+    }
+
+    increment(this->asset_hits, shard.asset_hits.load(std::memory_order_relaxed));
+    increment(this->asset_misses, shard.asset_misses.load(std::memory_order_relaxed));
+    increment(this->asset_not_modified, shard.asset_not_modified.load(std::memory_order_relaxed));
+    increment(this->statement_hits, shard.statement_hits.load(std::memory_order_relaxed));
+    increment(this->statement_misses, shard.statement_misses.load(std::memory_order_relaxed));
+    increment(this->access_log_dropped, shard.access_log_dropped.load(std::memory_order_relaxed));
+    increment(this->in_flight, shard.in_flight.load(std::memory_order_relaxed));
+}
+
+ff::Metrics::ShardHandle::ShardHandle() : shard(new MetricsShard{}) {
+    std::lock_guard<std::mutex> lock{metrics.mutex};
+    metrics.shards.push_back(this->shard);
+}
+
+ff::Metrics::ShardHandle::~ShardHandle() {
+    std::lock_guard<std::mutex> lock{metrics.mutex};
+
+    metrics.retired.merge(*this->shard);
+    metrics.shards.erase(std::remove(metrics.shards.begin(), metrics.shards.end(), this->shard), metrics.shards.end());
+
+    delete this->shard;
+}
+
+ff::MetricsShard& ff::Metrics::local() {
+    thread_local ShardHandle handle{};
+    return *handle.shard;
+}
+
+std::size_t ff::Metrics::register_route(const std::string_view route) {
+    std::lock_guard<std::mutex> lock{this->mutex};
+
+    if (const auto it = std::find(this->routes.begin(), this->routes.end(), route); it != this->routes.end()) {
+        return static_cast<std::size_t>(it - this->routes.begin());
+    }
+    if (this->routes.size() >= metrics_max_routes) {
+        throw std::runtime_error{"Too many routes registered for metrics."};
+    }
+
+    this->routes.emplace_back(route);
+    return this->routes.size() - 1;
+}
+
+void ff::Metrics::begin_request() {
+    increment(this->local().in_flight, int64_t{1});
+}
+
+void ff::Metrics::end_request(const std::size_t route, const int http_status, const int64_t duration) {
+    auto& shard = this->local();
+
+    shard.get_request(route, get_status_slot(http_status)).observe(duration);
+    increment(shard.in_flight, int64_t{-1});
+}
+
+void ff::Metrics::observe_database(const DatabaseOperation operation, const int64_t duration) {
+    this->local().database.at(static_cast<std::size_t>(operation)).observe(duration);
+}
+
+void ff::Metrics::observe_upload(const UploadStage stage, const int64_t duration) {
+    this->local().uploads.at(static_cast<std::size_t>(stage)).observe(duration);
+}
+
+void ff::Metrics::count_asset(const bool hit) {
+    auto& shard = this->local();
+    increment(hit ? shard.asset_hits : shard.asset_misses, uint64_t{1});
+}
+
+void ff::Metrics::count_asset_not_modified() {
+    increment(this->local().asset_not_modified, uint64_t{1});
+}
+
+void ff::Metrics::count_statement(const bool hit) {
+    auto& shard = this->local();
+    increment(hit ? shard.statement_hits : shard.statement_misses, uint64_t{1});
+}
+
+void ff::Metrics::count_access_log_dropped() {
+    increment(this->local().access_log_dropped, uint64_t{1});
+}
+
+std::string ff::Metrics::render() {
+    MetricsShard total{};
+    std::vector<std::string> route_names{};
+
+    {
+        std::lock_guard<std::mutex> lock{this->mutex};
+
+        total.merge(this->retired);
+        for (const auto& it : this->shards) {
+            total.merge(*it);
+        }
+        route_names = this->routes;
+    }
+
+    std::ostringstream ss{};
+
+    ss << "# HELP ff_http_requests_total Requests handled, by route and status code.\n";
+    ss << "# TYPE ff_http_requests_total counter\n";
+    for (std::size_t route{0}; route < route_names.size(); ++route) {
+        for (std::size_t slot{0}; slot < metrics_status_slots; ++slot) {
+            if (const Histogram* histogram = total.requests[route * metrics_status_slots + slot].load(std::memory_order_relaxed); histogram != nullptr) {
+                ss << "ff_http_requests_total{route=\"" << escape_label(route_names[route]) << "\",status=\"" << get_status_label(slot) << "\"} " << histogram->count() << "\n";
+            }
+        }
+    }
+
+    ss << "# HELP ff_http_request_duration_seconds Time spent handling requests, by route and status code.\n";
+    ss << "# TYPE ff_http_request_duration_seconds histogram\n";
+    for (std::size_t route{0}; route < route_names.size(); ++route) {
+        for (std::size_t slot{0}; slot < metrics_status_slots; ++slot) {
+            if (const Histogram* histogram = total.requests[route * metrics_status_slots + slot].load(std::memory_order_relaxed); histogram != nullptr) {
+                write_histogram(ss, "ff_http_request_duration_seconds", "route=\"" + escape_label(route_names[route]) + "\",status=\"" + get_status_label(slot) + "\"", *histogram);
+            }
+        }
+    }
+
+    ss << "# HELP ff_http_requests_in_flight Requests currently being handled.\n";
+    ss << "# TYPE ff_http_requests_in_flight gauge\n";
+    ss << "ff_http_requests_in_flight " << total.in_flight.load(std::memory_order_relaxed) << "\n";
+
+    ss << "# HELP ff_database_duration_seconds Time spent in database queries, by operation.\n";
+    ss << "# TYPE ff_database_duration_seconds histogram\n";
+    write_histogram(ss, "ff_database_duration_seconds", "operation=\"query\"", total.database.at(static_cast<std::size_t>(DatabaseOperation::Query)));
+    write_histogram(ss, "ff_database_duration_seconds", "operation=\"exec\"", total.database.at(static_cast<std::size_t>(DatabaseOperation::Exec)));
+
+    ss << "# HELP ff_database_statement_cache_hits_total Queries that reused a prepared statement.\n";
+    ss << "# TYPE ff_database_statement_cache_hits_total counter\n";
+    ss << "ff_database_statement_cache_hits_total " << total.statement_hits.load(std::memory_order_relaxed) << "\n";
+    ss << "# HELP ff_database_statement_cache_misses_total Queries that had to be prepared first.\n";
+    ss << "# TYPE ff_database_statement_cache_misses_total counter\n";
+    ss << "ff_database_statement_cache_misses_total " << total.statement_misses.load(std::memory_order_relaxed) << "\n";
+
+    ss << "# HELP ff_upload_stage_duration_seconds Time spent in each stage of processing an upload.\n";
+    ss << "# TYPE ff_upload_stage_duration_seconds histogram\n";
+    const std::array<std::string, metrics_upload_stages> stage_names{"multipart", "wad", "media", "store", "thumbnail"};
+    for (std::size_t i{0}; i < metrics_upload_stages; ++i) {
+        write_histogram(ss, "ff_upload_stage_duration_seconds", "stage=\"" + stage_names[i] + "\"", total.uploads[i]);
+    }
+
+    ss << "# HELP ff_asset_cache_hits_total Static assets served from memory.\n";
+    ss << "# TYPE ff_asset_cache_hits_total counter\n";
+    ss << "ff_asset_cache_hits_total " << total.asset_hits.load(std::memory_order_relaxed) << "\n";
+    ss << "# HELP ff_asset_cache_misses_total Static assets that had to be reloaded from disk.\n";
+    ss << "# TYPE ff_asset_cache_misses_total counter\n";
+    ss << "ff_asset_cache_misses_total " << total.asset_misses.load(std::memory_order_relaxed) << "\n";
+    ss << "# HELP ff_asset_not_modified_total Static asset requests answered with 304 Not Modified.\n";
+    ss << "# TYPE ff_asset_not_modified_total counter\n";
+    ss << "ff_asset_not_modified_total " << total.asset_not_modified.load(std::memory_order_relaxed) << "\n";
+
+    ss << "# HELP ff_access_log_dropped_total Access log records dropped because the buffer was full.\n";
+    ss << "# TYPE ff_access_log_dropped_total counter\n";
+    ss << "ff_access_log_dropped_total " << total.access_log_dropped.load(std::memory_order_relaxed) << "\n";
+
+    return ss.str();
+}
@@ -0,0 +1,316 @@
+#include <algorithm>
+#include <filesystem>
+#include <ff.hpp>
+#include <multipart_parser.hpp>
+#include <nlohmann/json.hpp>
+
+namespace {
+    constexpr std::size_t max_header_size{16 * 1024};
+    constexpr std::size_t chunk_size{64 * 1024};
+
+    std::string trim(const std::string& str) {
+        const auto first = str.find_first_not_of(" \t");
+        if (first == std::string::npos) {
+            return "";
+        }
+        return str.substr(first, str.find_last_not_of(" \t") - first + 1);
+    }
+}
+
+ff::MultipartParser::MultipartParser(const std::string& boundary, MultipartLimits limits) : delimiter("\r\n--" + boundary), limits(std::move(limits)) {}
+
+ff::MultipartStatus ff::MultipartParser::fail(const MultipartStatus reason) {
+    this->status = reason;
+    if (this->output.is_open()) {
+        this->output.close();
+    }
+    return this->status;
+}
+
+bool ff::MultipartParser::begin_part(const std::string& headers) {
+    std::string name{};
+    std::string filename{};
+
+    std::size_t pos = 0;
+    while (pos <= headers.size()) {
+        std::size_t end = headers.find("\r\n", pos);
+        if (end == std::string::npos) {
+            end = headers.size();
+        }
+
+        const std::string line = headers.substr(pos, end - pos);
+        pos = end + 2;
+
+        const auto colon = line.find(':');
+        if (colon == std::string::npos) {
+            continue;
+        }
+
+        std::string key = line.substr(0, colon);
+        std::transform(key.begin(), key.end(), key.begin(), ::tolower);
+        if (key != "content-disposition") {
+            continue;
+        }
+
+        // form-data; name="field"; filename="file.ext"
+        std::size_t param_pos = colon + 1;
+        while (param_pos < line.size()) {
+            std::size_t param_end = line.find(';', param_pos);
+            if (param_end == std::string::npos) {
+                param_end = line.size();
+            }
+
+            const std::string param = trim(line.substr(param_pos, param_end - param_pos));
+            param_pos = param_end + 1;
+
+            const auto equals = param.find('=');
+            if (equals == std::string::npos) {
+                continue;
+            }
+
+            const std::string param_key = param.substr(0, equals);
+            std::string value = param.substr(equals + 1);
+            if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+                value = value.substr(1, value.size() - 2);
+            }
+
+            if (param_key == "name") {
+                name = value;
+            } else if (param_key == "filename") {
+                filename = value;
+            }
+        }
+    }
+
+    if (name.empty()) {
+        this->fail(MultipartStatus::Malformed);
+        return false;
+    }
+    if (this->files.size() >= this->limits.max_parts) {
+        this->fail(MultipartStatus::TooManyParts);
+        return false;
+    }
+
+    const auto it = this->limits.part_limits.find(name);
+    this->part_limit = it != this->limits.part_limits.end() ? it->second : this->limits.max_part_size;
+
+    MultipartFile file{};
+    file.name = name;
+    file.filename = std::filesystem::path(filename).filename().string();
+    file.path = ff::get_temp_path();
+
+    this->output.open(file.path, std::ios::binary | std::ios::trunc);
+    if (!this->output.is_open()) {
+        this->fail(MultipartStatus::WriteFailed);
+        return false;
+    }
+
+    this->files.push_back(file);
+
+    return true;
+}
+
+bool ff::MultipartParser::write(const char* data, const std::size_t size) {
+    if (size == 0) {
+        return true;
+    }
+
+    auto& file = this->files.back();
+
+    if (this->part_limit != 0 && file.size + size > this->part_limit) {
+        this->fail(MultipartStatus::TooLarge);
+        return false;
+    }
+
+    this->output.write(data, static_cast<std::streamsize>(size));
+    if (!this->output) {
+        this->fail(MultipartStatus::WriteFailed);
+        return false;
+    }
+
+    file.size += size;
+
+    return true;
+}
+
+ff::MultipartStatus ff::MultipartParser::feed(const std::string_view chunk) {
+    if (this->status != MultipartStatus::Success || this->state == State::Done) {
+        return this->status;
+    }
+
+    // drop what has already been consumed before growing the buffer
+    if (this->position > 0 && this->position >= this->buffer.size() / 2) {
+        this->buffer.erase(0, this->position);
+        this->position = 0;
+    }
+
+    this->buffer.append(chunk);
+
+    while (true) {
+        switch (this->state) {
+            case State::Preamble: {
+                const auto pos = this->buffer.find(this->delimiter, this->position);
+                if (pos == std::string::npos) {
+                    if (this->buffer.size() - this->position > this->delimiter.size()) {
+                        this->position = this->buffer.size() - this->delimiter.size();
+                    }
+                    return this->status;
+                }
+
+                this->position = pos + this->delimiter.size();
+                this->state = State::Delimiter;
+                break;
+            }
+            case State::Delimiter: {
+                if (this->buffer.size() - this->position < 2) {
+                    return this->status;
+                }
+                if (this->buffer.compare(this->position, 2, "--") == 0) {
+                    this->position += 2;
+                    this->state = State::Done;
+                    return this->status;
+                }
+                if (this->buffer.compare(this->position, 2, "\r\n") != 0) {
+                    return this->fail(MultipartStatus::Malformed);
+                }
+
+                this->position += 2;
+                this->state = State::Headers;
+                break;
+            }
+            case State::Headers: {
+                const auto pos = this->buffer.find("\r\n\r\n", this->position);
+                if (pos == std::string::npos) {
+                    if (this->buffer.size() - this->position > max_header_size) {
+                        return this->fail(MultipartStatus::Malformed);
+                    }
+                    return this->status;
+                }
+
+                if (!this->begin_part(this->buffer.substr(this->position, pos - this->position))) {
+                    return this->status;
+                }
+
+                this->position = pos + 4;
+                this->state = State::Body;
+                break;
+            }
+            case State::Body: {
+                const auto pos = this->buffer.find(this->delimiter, this->position);
+                if (pos == std::string::npos) {
+                    // hold back anything that could be the start of a delimiter split across chunks
+                    const std::size_t keep = this->delimiter.size() - 1;
+                    if (this->buffer.size() - this->position > keep) {
+                        const std::size_t size = this->buffer.size() - keep - this->position;
+                        if (!this->write(this->buffer.data() + this->position, size)) {
+                            return this->status;
+                        }
+                        this->position += size;
+                    }
+                    return this->status;
+                }
+
+                if (!this->write(this->buffer.data() + this->position, pos - this->position)) {
+                    return this->status;
+                }
+
+                this->output.close();
+                this->position = pos + this->delimiter.size();
+                this->state = State::Delimiter;
+                break;
+            }
+            case State::Done:
+                return this->status;
+        }
+    }
+}
+
+ff::MultipartStatus ff::MultipartParser::finish() {
+    if (this->status == MultipartStatus::Success && this->state != State::Done) {
+        return this->fail(MultipartStatus::Malformed);
+    }
+
+    return this->status;
+}
+
+void ff::MultipartParser::discard() {
+    if (this->output.is_open()) {
+        this->output.close();
+    }
+
+    for (const auto& it : this->files) {
+        std::filesystem::remove(it.path);
+    }
+
+    this->files.clear();
+}
+
+const std::vector<ff::MultipartFile>& ff::MultipartParser::get_files() const {
+    return this->files;
+}
+
+std::string ff::get_multipart_boundary(const limhamn::http::server::request& request) {
+    const std::string content_type = get_header(request, "Content-Type");
+
+    if (const auto pos = content_type.find("boundary="); pos != std::string::npos) {
+        std::string boundary = content_type.substr(pos + 9);
+        if (const auto end = boundary.find(';'); end != std::string::npos) {
+            boundary.erase(end);
+        }
+        boundary = trim(boundary);
+        if (boundary.size() >= 2 && boundary.front() == '"' && boundary.back() == '"') {
+            boundary = boundary.substr(1, boundary.size() - 2);
+        }
+        return boundary;
+    }
+
+    // no header, so take it from the first line of the body
+    if (request.raw_body.compare(0, 2, "--") == 0) {
+        const auto end = request.raw_body.find("\r\n");
+        if (end != std::string::npos && end > 2) {
+            return request.raw_body.substr(2, end - 2);
+        }
+    }
+
+    return "";
+}
+
+std::pair<ff::MultipartStatus, std::vector<ff::MultipartFile>> ff::parse_multipart_form(const limhamn::http::server::request& request, const MultipartLimits& limits) {
+    const std::string boundary = get_multipart_boundary(request);
+    if (boundary.empty()) {
+        return {MultipartStatus::Malformed, {}};
+    }
+
+    MultipartParser parser{boundary, limits};
+
+    const std::string_view body{request.raw_body};
+    for (std::size_t pos = 0; pos < body.size(); pos += chunk_size) {
+        if (parser.feed(body.substr(pos, chunk_size)) != MultipartStatus::Success) {
+            break;
+        }
+    }
+
+    const auto status = parser.finish();
+    if (status != MultipartStatus::Success) {
+        logger.write_to_log(limhamn::logger::type::warning, "Rejected a multipart upload from " + request.ip_address + ".\n");
+        parser.discard();
+        return {status, {}};
+    }
+
+    return {status, parser.get_files()};
+}
+
+limhamn::http::server::response ff::make_multipart_error_response(const MultipartStatus status) {
+    limhamn::http::server::response response{};
+    response.content_type = "application/json";
+
+    nlohmann::json json;
+
+    json["error"] = status == MultipartStatus::TooLarge ? "FF_TOO_LARGE" : "FF_INVALID_MULTIPART";
+    json["error_str"] = status == MultipartStatus::TooLarge ? "An uploaded file is too large." : "Invalid multipart form data provided.";
+
+    response.body = json.dump();
+    response.http_status = status == MultipartStatus::TooLarge ? 413 : 400;
+
+    return response;
+}
@@ -0,0 +1,214 @@
+#include <algorithm>
+#include <stdexcept>
+#include <ff.hpp>
+#include <pagination.hpp>
+
+namespace {
+    // ids looked up with a single IN (...) at a time
+    constexpr std::size_t id_batch_size{64};
+
+    std::string get_sort_column(const ff::ListingSort sort) {
+        switch (sort) {
+            case ff::ListingSort::Downloads:
+                return "downloads";
+            case ff::ListingSort::Rating:
+                return "rating";
+            case ff::ListingSort::Relevance:
+                return "rank";
+            default:
+                return "id";
+        }
+    }
+}
+
+ff::PageRequest ff::parse_page_request(const nlohmann::json& input, const bool rankable) {
+    PageRequest page{};
+
+    if (!input.is_object()) {
+        return page;
+    }
+
+    if (input.contains("sort")) {
+        if (!input.at("sort").is_string()) {
+            throw std::invalid_argument{"sort must be a string"};
+        }
+
+        const std::string sort = input.at("sort").get<std::string>();
+        if (sort == "oldest") {
+            page.sort = ListingSort::Oldest;
+        } else if (sort == "newest") {
+            page.sort = ListingSort::Newest;
+        } else if (sort == "downloads" && rankable) {
+            page.sort = ListingSort::Downloads;
+        } else if (sort == "rating" && rankable) {
+            page.sort = ListingSort::Rating;
+        } else if (sort == "relevance" && rankable) {
+            page.sort = ListingSort::Relevance;
+        } else {
+            throw std::invalid_argument{"Unknown sort: " + sort};
+        }
+    }
+
+    if (input.contains("limit")) {
+        if (!input.at("limit").is_number_integer() || input.at("limit").get<int64_t>() < 1) {
+            throw std::invalid_argument{"limit must be a positive integer"};
+        }
+        page.limit = static_cast<std::size_t>(input.at("limit").get<int64_t>());
+    }
+
+    // the cursor is "<sort key>:<id>" of the last row the client was given
+    if (input.contains("cursor") && !input.at("cursor").is_null()) {
+        if (!input.at("cursor").is_string()) {
+            throw std::invalid_argument{"cursor must be a string"};
+        }
+
+        const std::string cursor = input.at("cursor").get<std::string>();
+        const auto separator = cursor.find(':');
+        if (separator == std::string::npos) {
+            throw std::invalid_argument{"Malformed cursor"};
+        }
+
+        try {
+            std::size_t key_end{0};
+            std::size_t id_end{0};
+            page.cursor_key = std::stoll(cursor.substr(0, separator), &key_end);
+            page.cursor_id = std::stoll(cursor.substr(separator + 1), &id_end);
+            if (key_end != separator || id_end != cursor.size() - separator - 1) {
+                throw std::invalid_argument{"Malformed cursor"};
+            }
+        } catch (const std::exception&) {
+            throw std::invalid_argument{"Malformed cursor"};
+        }
+
+        page.has_cursor = true;
+    }
+
+    // a client that pages must not be able to ask for the whole listing at once
+    if (page.has_cursor || page.limit != 0) {
+        page.limit = std::clamp<std::size_t>(page.limit == 0 ? settings.max_page_size : page.limit, 1, std::max<std::size_t>(settings.max_page_size, 1));
+    }
+
+    return page;
+}
+
+std::string ff::for_each_row_in_page(database& db, const std::string& from, const std::vector<std::string>& columns, const std::string& where,
+    const std::vector<DatabaseParameter>& parameters, const PageRequest& page,
+    const std::function<bool(const std::unordered_map<std::string, std::string>&)>& handle) {
+    const std::string column = get_sort_column(page.sort);
+    const bool ascending = page.sort == ListingSort::Oldest;
+    const std::string direction = ascending ? "ASC" : "DESC";
+    const std::string comparison = ascending ? ">" : "<";
+
+    std::string selected{"id, json"};
+    for (const auto& it : columns) {
+        selected += ", " + it;
+    }
+    if (column != "id") {
+        selected += ", " + column;
+    }
+
+    std::string order{" ORDER BY "};
+    if (column != "id") {
+        order += column + " " + direction + ", ";
+    }
+    order += "id " + direction;
+
+    // rows rejected by handle do not count towards the page, so keep reading batches until it is full
+    const std::size_t batch = page.limit == 0 ? 0 : page.limit + 1;
+
+    bool has_cursor = page.has_cursor;
+    int64_t cursor_key = page.cursor_key;
+    int64_t cursor_id = page.cursor_id;
+    std::size_t accepted{0};
+
+    while (true) {
+        std::string query{"SELECT " + selected + " FROM " + from + where};
+        std::vector<DatabaseParameter> query_parameters = parameters;
+
+        if (has_cursor) {
+            query += where.empty() ? " WHERE " : " AND ";
+            if (column == "id") {
+                query += "id " + comparison + " ?";
+                query_parameters.emplace_back(cursor_id);
+            } else {
+                query += "(" + column + " " + comparison + " ? OR (" + column + " = ? AND id " + comparison + " ?))";
+                query_parameters.emplace_back(cursor_key);
+                query_parameters.emplace_back(cursor_key);
+                query_parameters.emplace_back(cursor_id);
+            }
+        }
+
+        query += order;
+        if (batch != 0) {
+            query += " LIMIT " + std::to_string(batch);
+        }
+
+        const auto rows = db.query(query + ";", query_parameters);
+
+        for (std::size_t i{0}; i < rows.size(); ++i) {
+            const auto& row = rows[i];
+
+            cursor_id = std::stoll(row.at("id"));
+            cursor_key = column == "id" ? cursor_id : std::stoll(row.at(column));
+            has_cursor = true;
+
+            if (!handle(row)) {
+                continue;
+            }
+
+            if (++accepted == page.limit) {
+                // only hand out a cursor if there is something after this row
+                if (i + 1 < rows.size()) {
+                    return std::to_string(cursor_key) + ":" + std::to_string(cursor_id);
+                }
+                break;
+            }
+        }
+
+        if (batch == 0 || rows.size() < batch) {
+            return "";
+        }
+        if (accepted == page.limit) {
+            // the page filled on the last row of a full batch, so there may be more
+            return std::to_string(cursor_key) + ":" + std::to_string(cursor_id);
+        }
+    }
+}
+
+void ff::for_each_row_by_id(database& db, const std::string& table, const std::vector<std::string>& columns, const std::vector<int64_t>& ids,
+    const std::function<void(const std::unordered_map<std::string, std::string>&)>& handle) {
+    std::string selected{"id"};
+    for (const auto& it : columns) {
+        selected += ", " + it;
+    }
+
+    for (std::size_t begin{0}; begin < ids.size(); begin += id_batch_size) {
+        const std::size_t end = std::min(begin + id_batch_size, ids.size());
+
+        // the number of placeholders is rounded up to a power of two by repeating the last id, so
+        // at most seven distinct statements are prepared whatever the size of the batch
+        std::size_t count{1};
+        while (count < end - begin) {
+            count *= 2;
+        }
+
+        std::string placeholders{};
+        std::vector<DatabaseParameter> parameters{};
+        for (std::size_t i{0}; i < count; ++i) {
+            placeholders += placeholders.empty() ? "?" : ", ?";
+            parameters.emplace_back(ids[std::min(begin + i, end - 1)]);
+        }
+
+        std::unordered_map<int64_t, std::unordered_map<std::string, std::string>> rows{};
+        for (auto& it : db.query("SELECT " + selected + " FROM " + table + " WHERE id IN (" + placeholders + ");", parameters)) {
+            const int64_t id = std::stoll(it.at("id"));
+            rows.emplace(id, std::move(it));
+        }
+
+        for (std::size_t i{begin}; i < end; ++i) {
+            if (const auto it = rows.find(ids[i]); it != rows.end()) {
+                handle(it->second);
+            }
+        }
+    }
+}
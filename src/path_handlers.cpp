@@ -1,68 +1,25 @@
 #include <filesystem>
+#include <limits>
+#include <sys/stat.h>
 #include <ff.hpp>
 #include <scrypto.hpp>
 #include <limhamn/http/http_utils.hpp>
 #include <nlohmann/json.hpp>
 #include <maddy/parser.h>
-#include <static_exists.hpp>
+#include <asset_bundle.hpp>
+#include <metrics.hpp>
 #include <endpoint_handlers.hpp>
-
-limhamn::http::server::response ff::handle_root_endpoint(const limhamn::http::server::request&, database&) {
-    limhamn::http::server::response response{};
-
-    const auto prepare_file = [](const std::string& path) -> std::string {
-        static const std::string temp_file = settings.temp_directory + "/index.html";
-
-        if (static_exists.is_file(temp_file)) {
-            return temp_file;
-        }
-
-        std::filesystem::remove(temp_file);
-        std::filesystem::copy_file(path, temp_file);
-
-        // get domain from site url
-        std::string domain = settings.site_url;
-        if (domain.find("https://") != std::string::npos) {
-            domain = domain.substr(8);
-        } else if (domain.find("http://") != std::string::npos) {
-            domain = domain.substr(7);
-        }
-        if (domain.find('/') != std::string::npos) {
-            domain = domain.substr(0, domain.find('/'));
-        }
-        const std::vector<std::pair<std::string, std::string>> find_replace_table = {
-            {"{{ff_title}}", settings.title},
-            {"{{ff_description}}", settings.description},
-            {"{{ff_domain}}", domain},
-            {"{{ff_favicon_path}}", virtual_favicon_path},
-            {"{{ff_css_path}}", virtual_stylesheet_path},
-            {"{{ff_js_path}}", virtual_script_path},
-                {"{{ff_body_replace}}", needs_setup ? "<script>setup();</script>" : ""},
-            {"\n", ""},
-            {"\t", ""},
-        };
-
-        auto contents = open_file(temp_file);
-        for (const auto& it : find_replace_table) {
-            size_t pos = 0;
-            while ((pos = contents.find(it.first, pos)) != std::string::npos) {
-                contents.replace(pos, it.first.length(), it.second);
-                pos += it.second.length();
-            }
-        }
-
-        std::ofstream file(temp_file, std::ios::out);
-        file << contents;
-        file.close();
-
-        return temp_file;
-    };
-
-    response.content_type = "text/html";
-    response.http_status = 200;
-    response.body = ff::cache_manager.open_file(prepare_file(settings.html_file));
-
-    return response;
+#include <pagination.hpp>
+#include <listing_filter.hpp>
+#include <search.hpp>
+#include <download_log.hpp>
+#include <session_cache.hpp>
+#include <profile_cache.hpp>
+#include <catalog_snapshot.hpp>
+#include <catalog.hpp>
+
+limhamn::http::server::response ff::handle_root_endpoint(const limhamn::http::server::request& request, database&) {
+    return ff::asset_bundle.serve(request, "/");
 }
 
 limhamn::http::server::response ff::handle_try_upload_forwarder_endpoint(const limhamn::http::server::request& request, database& db) {
@@ -167,7 +124,7 @@ limhamn::http::server::response ff::handle_try_setup_endpoint(const limhamn::htt
     limhamn::http::server::response response{};
     response.content_type = "application/json";
 
-    if (!ff::needs_setup) {
+    if (!ff::check_needs_setup(db)) {
         response.location = "/";
         return response;
     }
@@ -229,21 +186,53 @@ limhamn::http::server::response ff::handle_try_setup_endpoint(const limhamn::htt
     const std::string& user_agent = request.user_agent;
     const std::string& email = input_json.at("email").get<std::string>();
 
-    AccountCreationStatus status = ff::make_account(
-            db,
-            username,
-            password,
-            email,
-            ip_address,
-            user_agent,
-            UserType::Administrator
-    );
+    // other workers accept setups too, so the check for an administrator and the insert share
+    // a transaction that holds the write lock (SQLite) or a lock on users (PostgreSQL)
+    if (!db.exec(db.is_postgres() ? "BEGIN;" : "BEGIN IMMEDIATE;")) {
+        response.http_status = 500;
+        nlohmann::json json;
+        json["error"] = "FF_FAILURE";
+        json["error_str"] = "Failure.";
+        response.body = json.dump();
+        return response;
+    }
+
+    AccountCreationStatus status{AccountCreationStatus::Failure};
+    bool setup_done{false};
+    try {
+        if (db.is_postgres() && !db.exec("LOCK TABLE users IN EXCLUSIVE MODE;")) {
+            throw std::runtime_error{"Failed to lock the users table."};
+        }
+
+        setup_done = ff::ensure_admin_account_exists(db);
+        if (!setup_done) {
+            status = ff::make_account(
+                    db,
+                    username,
+                    password,
+                    email,
+                    ip_address,
+                    user_agent,
+                    UserType::Administrator
+            );
+        }
+
+        if (status != AccountCreationStatus::Success || !db.exec("COMMIT;")) {
+            db.exec("ROLLBACK;");
+        }
+    } catch (const std::exception&) {
+        db.exec("ROLLBACK;");
+        status = AccountCreationStatus::Failure;
+    }
+
+    if (setup_done) {
+        static_cast<void>(ff::check_needs_setup(db));
+        response.location = "/";
+        return response;
+    }
 
     if (status == AccountCreationStatus::Success) {
-        std::filesystem::remove(settings.temp_directory + "/index.html");
-        ff::cache_manager = ff::CacheManager{};
-        ff::static_exists = ff::StaticExists{};
-        ff::needs_setup = false;
+        static_cast<void>(ff::check_needs_setup(db));
         response.http_status = 204;
         return response;
     } else {
@@ -275,79 +264,272 @@ limhamn::http::server::response ff::handle_try_setup_endpoint(const limhamn::htt
     }
 }
 
-limhamn::http::server::response ff::handle_virtual_favicon_endpoint(const limhamn::http::server::request&, database&) {
-    limhamn::http::server::response response{};
+limhamn::http::server::response ff::handle_virtual_favicon_endpoint(const limhamn::http::server::request& request, database&) {
+    return ff::asset_bundle.serve(request, virtual_favicon_path);
+}
 
-    response.content_type = "image/svg+xml";
-    response.http_status = 200;
+limhamn::http::server::response ff::handle_virtual_stylesheet_endpoint(const limhamn::http::server::request& request, database&) {
+    return ff::asset_bundle.serve(request, virtual_stylesheet_path);
+}
 
-    if (settings.favicon_file.empty() || !static_exists.is_file(settings.favicon_file)) {
-        response.http_status = 200;
-        response.body = "";
-        return response;
+limhamn::http::server::response ff::handle_virtual_script_endpoint(const limhamn::http::server::request& request, database&) {
+    return ff::asset_bundle.serve(request, virtual_script_path);
+}
+
+limhamn::http::server::response ff::handle_download_endpoint(const limhamn::http::server::request& request, database& db) {
+    std::string file = request.endpoint;
+
+    if (file.back() == '/') {
+        file.pop_back();
     }
 
-    response.body = ff::cache_manager.open_file(settings.favicon_file);
+    // "/download" or "/download/" names no file
+    if (file.size() <= 10) {
+        return ff::handle_not_found_endpoint(request, db);
+    }
 
-    return response;
-}
+    std::filesystem::path file_path = file.substr(10); // remove /download/
+    file_path = file_path.lexically_normal(); // normalize the path
+
+    // a single indexed read; a missing row or file throws
+    ff::RetrievedFile h{};
+    try {
+        h = ff::get_file(db, file_path.string());
+    } catch (const std::exception&) {
+        return ff::handle_not_found_endpoint(request, db);
+    }
+
+    struct stat st{};
+    if (stat(h.path.c_str(), &st) != 0) {
+        return ff::handle_not_found_endpoint(request, db);
+    }
+
+    const auto size = static_cast<std::uintmax_t>(st.st_size);
+    const std::string etag = "\"" + file_path.string() + "-" + std::to_string(size) + "-" + std::to_string(st.st_mtime) + "\"";
+    const std::string last_modified = ff::http_date(st.st_mtime);
 
-limhamn::http::server::response ff::handle_virtual_stylesheet_endpoint(const limhamn::http::server::request&, database&) {
     limhamn::http::server::response response{};
 
-    response.content_type = "text/css";
-    response.http_status = 200;
+    response.content_type = limhamn::http::utils::get_appropriate_content_type(h.name);
+    response.headers.push_back({"Accept-Ranges", "bytes"});
+    response.headers.push_back({"ETag", etag});
+    response.headers.push_back({"Last-Modified", last_modified});
 
-    if (settings.css_file.empty() || !static_exists.is_file(settings.css_file)) {
+    if (settings.preview_files) {
+        response.headers.push_back({"Content-Disposition", "inline; filename=\"" + h.name + "\""});
+    } else {
+        response.headers.push_back({"Content-Disposition", "attachment; filename=\"" + h.name + "\""});
+    }
+
+    // the body is left empty, so the length the file would have is given explicitly
+    if (request.method == "HEAD") {
         response.http_status = 200;
-        response.body = "";
+        response.headers.push_back({"Content-Length", std::to_string(size)});
         return response;
     }
 
-    response.body = ff::cache_manager.open_file(settings.css_file);
+    // only a single "bytes=first-last", "bytes=first-" or "bytes=-suffix" range is supported;
+    // anything else is ignored and the whole file is sent, as RFC 9110 requires
+    enum class RangeResult {
+        Unsupported,
+        Unsatisfiable,
+        Satisfiable,
+    };
+    const auto parse_range = [&size](const std::string& header, std::uintmax_t& first, std::uintmax_t& last) -> RangeResult {
+        if (header.find("bytes=") != 0 || header.find(',') != std::string::npos) {
+            return RangeResult::Unsupported;
+        }
 
-    return response;
-}
+        const std::string spec = header.substr(6);
+        const auto dash = spec.find('-');
+        if (dash == std::string::npos || spec.find_first_not_of("0123456789-") != std::string::npos || spec.find('-', dash + 1) != std::string::npos) {
+            return RangeResult::Unsupported;
+        }
 
-limhamn::http::server::response ff::handle_virtual_script_endpoint(const limhamn::http::server::request&, database&) {
-    limhamn::http::server::response response;
+        const std::string first_spec = spec.substr(0, dash);
+        const std::string last_spec = spec.substr(dash + 1);
+        if (first_spec.empty() && last_spec.empty()) {
+            return RangeResult::Unsupported;
+        }
 
-    response.content_type = "text/javascript";
-    response.http_status = 200;
+        // the spec is only digits by now, so the only failure left is a number too large, which is past the end anyway
+        const auto to_number = [](const std::string& str) -> std::uintmax_t {
+            try {
+                return std::stoull(str);
+            } catch (const std::exception&) {
+                return std::numeric_limits<std::uintmax_t>::max();
+            }
+        };
 
-    // TODO: Just like the name, this function is UGLY AS FUCK, and does not belong anywhere near
-    // a project like this. But I simply cannot be bothered to write a JS minifier myself, nor
-    // am I aware of any C++ library for doing such a thing, and I am therefore just going to call uglifyjs.
-#ifndef FF_DEBUG
-    const auto uglify_file = [](const std::string& path) -> std::string {
-        static const std::string temp_file = settings.temp_directory + "/ff_temp.js";
-        if (static_exists.is_file(temp_file)) {
-            return temp_file;
-        }
-        if (std::system("which uglifyjs > /dev/null") != 0) {
-            return path;
+        if (first_spec.empty()) {
+            const auto suffix = to_number(last_spec);
+            if (suffix == 0 || size == 0) {
+                return RangeResult::Unsatisfiable;
+            }
+            first = suffix >= size ? 0 : size - suffix;
+            last = size - 1;
+            return RangeResult::Satisfiable;
         }
 
-        std::filesystem::remove(temp_file);
-        std::filesystem::copy_file(path, temp_file);
+        first = to_number(first_spec);
+        last = last_spec.empty() ? std::numeric_limits<std::uintmax_t>::max() : to_number(last_spec);
 
-        // run uglifyjs on the file
-        std::string command = "uglifyjs " + temp_file + " -o " + temp_file;
-        if (std::system(command.c_str()) != 0) {
-        	return path;
+        if (last < first) {
+            return RangeResult::Unsupported;
+        }
+        if (first >= size) {
+            return RangeResult::Unsatisfiable;
         }
 
-        return temp_file;
+        last = std::min<std::uintmax_t>(last, size - 1);
+        return RangeResult::Satisfiable;
     };
-#endif
+
+    std::string range = get_header(request, "Range");
+    const std::string if_range = get_header(request, "If-Range");
+
+    // the file has changed since the client got its copy, so send the whole thing
+    if (!range.empty() && !if_range.empty() && if_range != etag && if_range != last_modified) {
+        range.clear();
+    }
+
+    std::uintmax_t first{0};
+    std::uintmax_t last{size == 0 ? 0 : size - 1};
+
+    if (!range.empty()) {
+        switch (parse_range(range, first, last)) {
+            case RangeResult::Unsupported:
+                range.clear();
+                first = 0;
+                last = size == 0 ? 0 : size - 1;
+                break;
+            case RangeResult::Unsatisfiable:
+                response.http_status = 416;
+                response.headers.push_back({"Content-Range", "bytes */" + std::to_string(size)});
+                return response;
+            case RangeResult::Satisfiable:
+                break;
+        }
+    }
+
+    // resumed downloads are not counted again
+    if (first == 0) {
+        ff::download_log.push(file_path.string(), ff::UserProperties{
+            .username = request.session.find("username") != request.session.end() ? request.session.at("username") : "",
+            .ip_address = request.ip_address,
+            .user_agent = request.user_agent,
+        });
+    }
 
 #if FF_DEBUG
-    response.body = ff::cache_manager.open_file(settings.script_file);
-#else
-    std::string path = uglify_file(settings.script_file);
-    response.body = ff::cache_manager.open_file(path);
+    logger.write_to_log(limhamn::logger::type::notice, "File download request for: " + h.path + "\n");
 #endif
 
+    // hand the file over to the reverse proxy, which also takes care of ranges
+    if (settings.download_offload != DownloadOffload::None) {
+        const auto path = std::filesystem::weakly_canonical(h.path);
+        const auto relative = path.lexically_relative(std::filesystem::weakly_canonical(settings.data_directory));
+
+        if (!relative.empty() && relative.begin()->string() != "..") {
+            response.http_status = 200;
+
+            if (settings.download_offload == DownloadOffload::XAccelRedirect) {
+                std::string prefix = settings.download_offload_prefix;
+                if (prefix.empty() || prefix.back() != '/') {
+                    prefix += '/';
+                }
+                response.headers.push_back({"X-Accel-Redirect", prefix + relative.generic_string()});
+            } else {
+                response.headers.push_back({"X-Sendfile", path.string()});
+            }
+
+            return response;
+        }
+
+        logger.write_to_log(limhamn::logger::type::warning, "File " + h.path + " is outside the data directory and cannot be offloaded.\n");
+    }
+
+    if (range.empty()) {
+        response.http_status = 200;
+        response.body = open_file(h.path, 0, size);
+    } else {
+        response.http_status = 206;
+        response.headers.push_back({"Content-Range", "bytes " + std::to_string(first) + "-" + std::to_string(last) + "/" + std::to_string(size)});
+        response.body = open_file(h.path, first, last - first + 1);
+    }
+
+    return response;
+}
+
+limhamn::http::server::response ff::handle_activate_endpoint(const limhamn::http::server::request& request, database& db) {
+    if (!settings.enable_email_verification) {
+        return ff::handle_not_found_endpoint(request, db);
+    }
+
+    std::string file = request.endpoint;
+
+    if (file.back() == '/') {
+        file.pop_back();
+    }
+
+    const auto& list = db.query("SELECT * FROM activation_urls WHERE url = ?;", file);
+    for (const auto& it : list) {
+        try {
+            if (!patch_json_in_table(db, "users", "username", it.at("username"), {{ff::JsonPatchOperation::Set, {"activated"}, true}})) {
+                break;
+            }
+
+            session_cache.invalidate(it.at("username"));
+
+            db.exec("DELETE FROM activation_urls WHERE url = ?;", file);
+
+            // redirect to /
+            limhamn::http::server::response response{};
+            response.http_status = 302;
+            response.headers.push_back({"Location", "/"});
+            return response;
+        } catch (const std::exception&) {
+            limhamn::http::server::response resp;
+            resp.content_type = "text/html";
+            resp.http_status = 500;
+            resp.body = "<p>500 Internal Server Error</p>";
+            return resp;
+        }
+    }
+
+    return ff::handle_not_found_endpoint(request, db);
+}
+
+limhamn::http::server::response ff::handle_not_found_endpoint(const limhamn::http::server::request&, database&) {
+    limhamn::http::server::response response{};
+
+    response.content_type = "text/html";
+    response.http_status = 404;
+    response.body = "<p>404 Not Found</p>";
+
+    return response;
+}
+
+limhamn::http::server::response ff::handle_metrics_endpoint(const limhamn::http::server::request& request, database& db) {
+    if (!settings.enable_metrics) {
+        return ff::handle_not_found_endpoint(request, db);
+    }
+
+    limhamn::http::server::response response{};
+
+    if (settings.restrict_metrics_to_whitelist &&
+        std::find(settings.whitelisted_ips.begin(), settings.whitelisted_ips.end(), request.ip_address) == settings.whitelisted_ips.end()) {
+        response.content_type = "text/plain";
+        response.http_status = 403;
+        response.body = "Forbidden";
+
+        return response;
+    }
+
+    response.content_type = "text/plain; version=0.0.4";
+    response.http_status = 200;
+    response.body = metrics.render();
+
     return response;
 }
 
@@ -594,28 +776,8 @@ limhamn::http::server::response ff::handle_api_get_forwarders_endpoint(const lim
     response.content_type = "application/json";
     response.http_status = 200;
 
-    // find filter in the json
-    struct Filter {
-        bool is_forwarder{false}; // if true, must be a forwarder
-        bool accepted{false}; // if true, must be accepted
-        bool needs_review{false}; // if true, must need review
-        std::string search_string{}; // if not empty, must contain this string somewhere
-        std::string title_id_string{}; // if not empty, must match this title id
-        std::string uploader{}; // if not empty, must match this uploader
-        std::string author{}; // if not empty, must match this author
-        int type{-1}; // if not -1, must match this type (1 = channel, 0 = forwarder)
-        std::vector<std::string> categories{}; // if not empty, must match one of these categories
-        std::string location{}; // if not empty, must match this location
-        int64_t submitted_before{-1}; // if not -1, must be submitted before this time
-        int64_t submitted_after{-1}; // if not -1, must be submitted after this time
-        std::pair<int64_t, int64_t> submitted_between{-1, -1}; // if not -1, must be submitted between these times
-        int vwii{-1}; // if not -1, must match this vwii (-1 = any, 0 = no vwii, 1 = vwii)
-        int begin{-1}; // if not -1, start at this index
-        int end{-1}; // if not -1, end at this index
-        std::string identifier{}; // if not empty, must match this identifier
-    };
-
-    Filter filter{};
+    ff::ListingFilter filter{};
+    ff::PageRequest page{};
 
     if (request.method == "POST" && !request.body.empty()) {
         nlohmann::json input_json;
@@ -629,271 +791,124 @@ limhamn::http::server::response ff::handle_api_get_forwarders_endpoint(const lim
             return response;
         }
 
-        // parse and override the filter
-        if (input_json.find("filter") != input_json.end() && input_json.at("filter").is_object()) {
-            if (input_json.at("filter").find("is_forwarder") != input_json.at("filter").end() && input_json.at("filter").at("is_forwarder").is_boolean()) {
-                filter.is_forwarder = input_json.at("filter").at("is_forwarder").get<bool>();
-            }
-            if (input_json.at("filter").find("accepted") != input_json.at("filter").end() && input_json.at("filter").at("accepted").is_boolean()) {
-                filter.accepted = input_json.at("filter").at("accepted").get<bool>();
-            }
-            if (input_json.at("filter").find("needs_review") != input_json.at("filter").end() && input_json.at("filter").at("needs_review").is_boolean()) {
-                filter.needs_review = input_json.at("filter").at("needs_review").get<bool>();
-            }
-            if (input_json.at("filter").find("search_string") != input_json.at("filter").end() && input_json.at("filter").at("search_string").is_string()) {
-                filter.search_string = input_json.at("filter").at("search_string").get<std::string>();
-            }
-            if (input_json.at("filter").find("title_id_string") != input_json.at("filter").end() && input_json.at("filter").at("title_id_string").is_string()) {
-                filter.title_id_string = input_json.at("filter").at("title_id_string").get<std::string>();
-            }
-            if (input_json.at("filter").find("uploader") != input_json.at("filter").end() && input_json.at("filter").at("uploader").is_string()) {
-                filter.uploader = input_json.at("filter").at("uploader").get<std::string>();
-            }
-            if (input_json.at("filter").find("author") != input_json.at("filter").end() && input_json.at("filter").at("author").is_string()) {
-                filter.author = input_json.at("filter").at("author").get<std::string>();
-            }
-            if (input_json.at("filter").find("type") != input_json.at("filter").end() && input_json.at("filter").at("type").is_number_integer()) {
-                filter.type = input_json.at("filter").at("type").get<int>();
-                if (filter.type != -1 && filter.type != 0 && filter.type != 1) {
-                    filter.type = -1;
-                }
-            }
-            if (input_json.at("filter").find("categories") != input_json.at("filter").end() && input_json.at("filter").at("categories").is_array()) {
-                for (const auto& it : input_json.at("filter").at("categories")) {
-                    if (it.is_string()) {
-                        filter.categories.push_back(it.get<std::string>());
-                    }
-                }
-            }
-            if (input_json.at("filter").find("location") != input_json.at("filter").end() && input_json.at("filter").at("location").is_string()) {
-                filter.location = input_json.at("filter").at("location").get<std::string>();
-            }
-            if (input_json.at("filter").find("submitted_before") != input_json.at("filter").end() && input_json.at("filter").at("submitted_before").is_number_integer()) {
-                filter.submitted_before = input_json.at("filter").at("submitted_before").get<int64_t>();
-            }
-            if (input_json.at("filter").find("submitted_after") != input_json.at("filter").end() && input_json.at("filter").at("submitted_after").is_number_integer()) {
-                filter.submitted_after = input_json.at("filter").at("submitted_after").get<int64_t>();
-            }
-            if (input_json.at("filter").find("submitted_between") != input_json.at("filter").end() && input_json.at("filter").at("submitted_between").is_array()) {
-                if (input_json.at("filter").at("submitted_between").size() == 2) {
-                    if (input_json.at("filter").at("submitted_between").at(0).is_number_integer() && input_json.at("filter").at("submitted_between").at(1).is_number_integer()) {
-                        filter.submitted_between = std::make_pair(input_json.at("filter").at("submitted_between").at(0).get<int64_t>(), input_json.at("filter").at("submitted_between").at(1).get<int64_t>());
-                    }
-                }
-            }
-            if (input_json.at("filter").find("vwii") != input_json.at("filter").end() && input_json.at("filter").at("vwii").is_number_integer()) {
-                filter.vwii = input_json.at("filter").at("vwii").get<int>();
-                if (filter.vwii != 0 && filter.vwii != 1) {
-                    filter.vwii = -1;
-                }
-            }
-            if (input_json.at("filter").find("begin") != input_json.at("filter").end() && input_json.at("filter").at("begin").is_number_integer()) {
-                filter.begin = input_json.at("filter").at("begin").get<int>();
-            }
-            if (input_json.at("filter").find("end") != input_json.at("filter").end() && input_json.at("filter").at("end").is_number_integer()) {
-                filter.end = input_json.at("filter").at("end").get<int>();
-            }
-            if (input_json.at("filter").find("identifier") != input_json.at("filter").end() && input_json.at("filter").at("identifier").is_string()) {
-                filter.identifier = input_json.at("filter").at("identifier").get<std::string>();
+        if (input_json.find("filter") != input_json.end()) {
+            filter = ff::parse_listing_filter(input_json.at("filter"), "forwarders");
+        }
+
+        try {
+            page = ff::parse_page_request(input_json, true);
+            if (!input_json.contains("sort") && !filter.search_string.empty()) {
+                page.sort = ff::ListingSort::Relevance;
             }
+        } catch (const std::invalid_argument&) {
+            response.http_status = 400;
+            response.body = "Bad Request";
+
+            return response;
+        }
+        if (page.limit == 0 && filter.end != -1) {
+            page.limit = static_cast<std::size_t>(std::max(filter.end - std::max(filter.begin, 0) + 1, 1));
+        }
+    }
+
+    // this is what the browse page asks for, so it is answered from a snapshot of the catalog
+    if (filter.is_default_browse() && page.sort == ff::ListingSort::Oldest && page.limit == 0 && !page.has_cursor) {
+        try {
+            return asset_bundle.serve(request, *catalog_snapshot.get(db));
+        } catch (const std::exception& e) {
+            logger.write_to_log(limhamn::logger::type::error, "Failed to build the catalog snapshot: " + std::string(e.what()) + "\n");
         }
     }
 
     nlohmann::json json{};
 
     json["forwarders"] = nlohmann::json::array();
+    json["next_cursor"] = nullptr;
 
     const auto get_forwarders = [&]() -> void {
         nlohmann::json forwarders_json;
 
-        std::vector<std::unordered_map<std::string, std::string>> forwarders;
-        if (!filter.identifier.empty()) {
-            forwarders = db.query("SELECT * FROM forwarders WHERE identifier = ?;", filter.identifier);
-        } else {
-            forwarders = db.query("SELECT * FROM forwarders;");
-        }
+        // rating_sum and rating_count are kept up to date by ff::set_rating()
+        const auto add_counts = [](nlohmann::json& forwarder, const std::unordered_map<std::string, std::string>& it) -> void {
+            const int64_t rating_sum = std::stoll(it.at("rating_sum"));
+            const int64_t rating_count = std::stoll(it.at("rating_count"));
+            // truncated to an integer, which is what clients have always been sent
+            forwarder["average_rating"] = rating_count > 0 ? rating_sum / rating_count : 0;
+            forwarder["rating_count"] = rating_count;
+            forwarder["ratings"] = nlohmann::json::object();
+
+            // the comments themselves are paged through /api/get_comments
+            forwarder["comment_count"] = std::stoll(it.at("comment_count"));
+        };
 
-        int i = 0;
-        for (const auto& it : forwarders) {
-            if (filter.begin != -1 && i < filter.begin) {
-                continue;
-            } else if (filter.end != -1 && i > filter.end) {
-                break;
+        // without a search, the listing is filtered and ordered by the catalog in memory
+        const std::string search_query = ff::make_search_query(filter.search_string, db.is_postgres());
+        if (search_query.empty()) {
+            if (page.sort == ff::ListingSort::Relevance) {
+                page.sort = ff::ListingSort::Oldest;
             }
 
             try {
-                forwarders_json = nlohmann::json::parse(it.at("json"));
-            } catch (const std::exception&) {
-                continue;
-            }
-
-            if (forwarders_json.find("meta") == forwarders_json.end()) {
-                continue;
-            }
+                const ff::CatalogPage catalog_page = ff::forwarder_catalog.select(db, filter, page);
+                ff::forwarder_catalog.for_each_row(db, catalog_page, {"rating_sum", "rating_count", "comment_count"}, [&](const std::unordered_map<std::string, std::string>& it) -> void {
+                    try {
+                        forwarders_json = *ff::get_parsed_json_from_row("forwarders", it);
+                    } catch (const std::exception&) {
+                        return;
+                    }
 
-            nlohmann::json meta;
-            try {
-                meta = forwarders_json.at("meta");
-            } catch (const std::exception&) {
-                return;
-            }
+                    add_counts(forwarders_json, it);
+                    json["forwarders"].push_back(forwarders_json);
+                });
 
-            if (filter.accepted && forwarders_json.find("needs_review") != forwarders_json.end() && forwarders_json.at("needs_review").is_boolean()) {
-                if (forwarders_json.at("needs_review").get<bool>()) {
-                    continue;
-                }
-            }
-            if (filter.needs_review && forwarders_json.find("needs_review") != forwarders_json.end() && forwarders_json.at("needs_review").is_boolean()) {
-                if (!forwarders_json.at("needs_review").get<bool>()) {
-                    continue;
+                if (!catalog_page.next_cursor.empty()) {
+                    json["next_cursor"] = catalog_page.next_cursor;
                 }
+
+                return;
+            } catch (const std::exception& e) {
+                logger.write_to_log(limhamn::logger::type::error, "Failed to filter the forwarders catalog: " + std::string(e.what()) + "\n");
+                json["forwarders"] = nlohmann::json::array();
             }
-            if (!filter.search_string.empty()) {
-                std::string full_str{};
+        }
 
-                if (meta.find("title") != meta.end() && meta.at("title").is_string()) {
-                    full_str += meta.at("title").get<std::string>();
-                }
-                if (meta.find("author") != meta.end() && meta.at("author").is_string()) {
-                    full_str += meta.at("author").get<std::string>();
-                }
-                if (meta.find("description") != meta.end() && meta.at("description").is_string()) {
-                    full_str += meta.at("description").get<std::string>();
-                }
-                if (meta.find("title_id") != meta.end() && meta.at("title_id").is_string()) {
-                    full_str += meta.at("title_id").get<std::string>();
-                }
-                if (forwarders_json.find("uploader") != forwarders_json.end() && forwarders_json.at("uploader").is_string()) {
-                    full_str += forwarders_json.at("uploader").get<std::string>();
-                }
+        // everything but the categories is filtered by the database, on the listing columns; see ff::ListingFilter
+        std::vector<ff::DatabaseParameter> parameters{};
+        const std::string where = filter.get_where(parameters);
 
-                std::transform(full_str.begin(), full_str.end(), full_str.begin(), ::tolower);
-                std::transform(filter.search_string.begin(), filter.search_string.end(), filter.search_string.begin(), ::tolower);
+        // searches run against the full-text index, which also ranks the results
+        std::string from{"forwarders"};
+        if (!search_query.empty()) {
+            from = ff::get_search_source("forwarders", db.is_postgres());
+            parameters.insert(parameters.begin(), search_query);
+        }
 
-                if (full_str.find(filter.search_string) == std::string::npos) {
-                    continue;
-                }
-            }
-            if (!filter.uploader.empty()) {
-                if (forwarders_json.find("uploader") != forwarders_json.end() && forwarders_json.at("uploader").is_string()) {
-                    std::transform(filter.uploader.begin(), filter.uploader.end(), filter.uploader.begin(), ::tolower);
-                    std::string uploader{forwarders_json.at("uploader").get<std::string>()};
-                    std::transform(uploader.begin(), uploader.end(), uploader.begin(), ::tolower);
-                    if (uploader != filter.uploader) {
-                        continue;
-                    }
-                }
-            }
-            if (!filter.author.empty()) {
-                if (meta.find("author") != meta.end() && meta.at("author").is_string()) {
-                    std::transform(filter.author.begin(), filter.author.end(), filter.author.begin(), ::tolower);
-                    std::string author{meta.at("author").get<std::string>()};
-                    std::transform(author.begin(), author.end(), author.begin(), ::tolower);
-                    if (author != filter.author) {
-                        continue;
-                    }
-                }
-            }
-            if (filter.type != -1) {
-                if (meta.find("type") != meta.end() && meta.at("type").is_number_integer()) {
-                    if (meta.at("type").get<int>() != filter.type) {
-                        continue;
-                    }
-                }
+        int skipped{0};
+        const std::string next_cursor = ff::for_each_row_in_page(db, from, {"version", "rating_sum", "rating_count", "comment_count"}, where, parameters, page, [&](const std::unordered_map<std::string, std::string>& it) -> bool {
+            try {
+                forwarders_json = *ff::get_parsed_json_from_row("forwarders", it);
+            } catch (const std::exception&) {
+                return false;
             }
 
-            if (!filter.categories.empty()) {
-                bool found = false;
-
-                for (const auto& category : filter.categories) {
-                    if (meta.find("categories") != meta.end() && meta.at("categories").is_array()) {
-                        for (const auto& it_category : meta.at("categories")) {
-                            if (it_category.is_string()) {
-                                std::string cat{it_category.get<std::string>()};
-                                std::transform(cat.begin(), cat.end(), cat.begin(), ::tolower);
-                                if (cat == category) {
-                                    found = true;
-                                    break;
-                                }
-                            }
-                        }
-
-                        if (found) break;
-                    }
-                }
-
-                if (!found) {
-                    continue;
-                }
-            }
-            if (!filter.location.empty()) {
-                if (meta.find("location") != meta.end() && meta.at("location").is_string()) {
-                    std::transform(filter.location.begin(), filter.location.end(), filter.location.begin(), ::tolower);
-                    std::string location{meta.at("location").get<std::string>()};
-                    std::transform(location.begin(), location.end(), location.begin(), ::tolower);
-                    if (location != filter.location) {
-                        continue;
-                    }
-                }
-            }
-            if (filter.submitted_before != -1) {
-                if (forwarders_json.find("submitted") != forwarders_json.end() && forwarders_json.at("submitted").is_number_integer()) {
-                    if (forwarders_json.at("submitted").get<int64_t>() > filter.submitted_before) {
-                        continue;
-                    }
-                }
-            }
-            if (filter.submitted_after != -1) {
-                if (forwarders_json.find("submitted") != forwarders_json.end() && forwarders_json.at("submitted").is_number_integer()) {
-                    if (forwarders_json.at("submitted").get<int64_t>() < filter.submitted_after) {
-                        continue;
-                    }
-                }
-            }
-            if (filter.submitted_between.first != -1 && filter.submitted_between.second != -1) {
-                if (forwarders_json.find("submitted") != forwarders_json.end() && forwarders_json.at("submitted").is_number_integer()) {
-                    if (forwarders_json.at("submitted").get<int64_t>() < filter.submitted_between.first || forwarders_json.at("submitted").get<int64_t>() > filter.submitted_between.second) {
-                        continue;
-                    }
-                }
-            }
-            if (filter.vwii != -1) {
-                if (meta.find("vwii_compatible") != meta.end() && meta.at("vwii_compatible").is_boolean()) {
-                    if (meta.at("vwii_compatible").get<bool>() != filter.vwii) {
-                        continue;
-                    }
-                }
+            // the categories and filename are only in the JSON
+            if (!filter.matches(ff::get_listing_document(forwarders_json))) {
+                return false;
             }
 
-            // replace [ratings] with a single average integer from [ratings][username][rating]
-            if (forwarders_json.find("ratings") != forwarders_json.end() && forwarders_json.at("ratings").is_object()) {
-                int total_rating = 0;
-                int count = 0;
-
-                for (const auto& _it : forwarders_json.at("ratings").items()) {
-                    if (_it.value().at("rating").is_number_integer()) {
-                        total_rating += _it.value().at("rating").get<int>();
-                        ++count;
-                    }
-                }
-
-                if (count > 0) {
-                    forwarders_json["average_rating"] = total_rating / count;
-                    forwarders_json["rating_count"] = count;
-                    forwarders_json["ratings"] = nlohmann::json::object();
-                } else {
-                    forwarders_json["average_rating"] = 0;
-                    forwarders_json["rating_count"] = 0;
-                    forwarders_json["ratings"] = nlohmann::json::object();
-                }
-            } else {
-                forwarders_json["average_rating"] = 0;
-                forwarders_json["rating_count"] = 0;
-                forwarders_json["ratings"] = nlohmann::json::object();
+            // begin and end predate cursors; end is turned into the page limit
+            if (filter.begin > 0 && skipped < filter.begin) {
+                ++skipped;
+                return false;
             }
 
+            add_counts(forwarders_json, it);
             json["forwarders"].push_back(forwarders_json);
-            ++i;
+            return true;
+        });
+
+        if (!next_cursor.empty()) {
+            json["next_cursor"] = next_cursor;
         }
     };
 
@@ -910,25 +925,8 @@ limhamn::http::server::response ff::handle_api_get_files_endpoint(const limhamn:
     response.content_type = "application/json";
     response.http_status = 200;
 
-    // find filter in the json
-    struct Filter {
-        bool accepted{false}; // if true, must be accepted
-        bool needs_review{false}; // if true, must need review
-        std::string search_string{}; // if not empty, must contain this string somewhere
-        std::string filename{}; // if not empty, must have this file
-        std::string title{}; // if not empty, must contain this title
-        std::string uploader{}; // if not empty, must match this uploader
-        std::string author{}; // if not empty, must match this author
-        std::vector<std::string> categories{}; // if not empty, must match one of these categories
-        int64_t submitted_before{-1}; // if not -1, must be submitted before this time
-        int64_t submitted_after{-1}; // if not -1, must be submitted after this time
-        std::pair<int64_t, int64_t> submitted_between{-1, -1}; // if not -1, must be submitted between these times
-        int begin{-1}; // if not -1, start at this index
-        int end{-1}; // if not -1, end at this index
-        std::string identifier{}; // if not empty, must match this identifier
-    };
-
-    Filter filter{};
+    ff::ListingFilter filter{};
+    ff::PageRequest page{};
 
     if (request.method == "POST" && !request.body.empty()) {
         nlohmann::json input_json;
@@ -942,250 +940,115 @@ limhamn::http::server::response ff::handle_api_get_files_endpoint(const limhamn:
             return response;
         }
 
-        // parse and override the filter
-        if (input_json.find("filter") != input_json.end() && input_json.at("filter").is_object()) {
-            if (input_json.at("filter").find("accepted") != input_json.at("filter").end() && input_json.at("filter").at("accepted").is_boolean()) {
-                filter.accepted = input_json.at("filter").at("accepted").get<bool>();
-            }
-            if (input_json.at("filter").find("needs_review") != input_json.at("filter").end() && input_json.at("filter").at("needs_review").is_boolean()) {
-                filter.needs_review = input_json.at("filter").at("needs_review").get<bool>();
-            }
-            if (input_json.at("filter").find("search_string") != input_json.at("filter").end() && input_json.at("filter").at("search_string").is_string()) {
-                filter.search_string = input_json.at("filter").at("search_string").get<std::string>();
-            }
-            if (input_json.at("filter").find("filename") != input_json.at("filter").end() && input_json.at("filter").at("filename").is_string()) {
-                filter.filename = input_json.at("filter").at("filename").get<std::string>();
-            }
-            if (input_json.at("filter").find("title") != input_json.at("filter").end() && input_json.at("filter").at("title").is_string()) {
-                filter.title = input_json.at("filter").at("title").get<std::string>();
-            }
-            if (input_json.at("filter").find("uploader") != input_json.at("filter").end() && input_json.at("filter").at("uploader").is_string()) {
-                filter.uploader = input_json.at("filter").at("uploader").get<std::string>();
-            }
-            if (input_json.at("filter").find("author") != input_json.at("filter").end() && input_json.at("filter").at("author").is_string()) {
-                filter.author = input_json.at("filter").at("author").get<std::string>();
-            }
-            if (input_json.at("filter").find("categories") != input_json.at("filter").end() && input_json.at("filter").at("categories").is_array()) {
-                for (const auto& it : input_json.at("filter").at("categories")) {
-                    if (it.is_string()) {
-                        filter.categories.push_back(it.get<std::string>());
-                    }
-                }
-            }
-            if (input_json.at("filter").find("submitted_before") != input_json.at("filter").end() && input_json.at("filter").at("submitted_before").is_number_integer()) {
-                filter.submitted_before = input_json.at("filter").at("submitted_before").get<int64_t>();
-            }
-            if (input_json.at("filter").find("submitted_after") != input_json.at("filter").end() && input_json.at("filter").at("submitted_after").is_number_integer()) {
-                filter.submitted_after = input_json.at("filter").at("submitted_after").get<int64_t>();
-            }
-            if (input_json.at("filter").find("submitted_between") != input_json.at("filter").end() && input_json.at("filter").at("submitted_between").is_array()) {
-                if (input_json.at("filter").at("submitted_between").size() == 2) {
-                    if (input_json.at("filter").at("submitted_between").at(0).is_number_integer() && input_json.at("filter").at("submitted_between").at(1).is_number_integer()) {
-                        filter.submitted_between = std::make_pair(input_json.at("filter").at("submitted_between").at(0).get<int64_t>(), input_json.at("filter").at("submitted_between").at(1).get<int64_t>());
-                    }
-                }
-            }
-            if (input_json.at("filter").find("begin") != input_json.at("filter").end() && input_json.at("filter").at("begin").is_number_integer()) {
-                filter.begin = input_json.at("filter").at("begin").get<int>();
-            }
-            if (input_json.at("filter").find("end") != input_json.at("filter").end() && input_json.at("filter").at("end").is_number_integer()) {
-                filter.end = input_json.at("filter").at("end").get<int>();
-            }
-            if (input_json.at("filter").find("identifier") != input_json.at("filter").end() && input_json.at("filter").at("identifier").is_string()) {
-                filter.identifier = input_json.at("filter").at("identifier").get<std::string>();
+        if (input_json.find("filter") != input_json.end()) {
+            filter = ff::parse_listing_filter(input_json.at("filter"), "sandbox");
+        }
+
+        try {
+            page = ff::parse_page_request(input_json, true);
+            if (!input_json.contains("sort") && !filter.search_string.empty()) {
+                page.sort = ff::ListingSort::Relevance;
             }
+        } catch (const std::invalid_argument&) {
+            response.http_status = 400;
+            response.body = "Bad Request";
+
+            return response;
+        }
+        if (page.limit == 0 && filter.end != -1) {
+            page.limit = static_cast<std::size_t>(std::max(filter.end - std::max(filter.begin, 0) + 1, 1));
         }
     }
 
     nlohmann::json json{};
 
     json["files"] = nlohmann::json::array();
+    json["next_cursor"] = nullptr;
 
     const auto get_files = [&]() -> void {
         nlohmann::json files_json;
 
-        std::vector<std::unordered_map<std::string, std::string>> files;
-        if (!filter.identifier.empty()) {
-            files = db.query("SELECT * FROM sandbox WHERE identifier = ?;", filter.identifier);
-        } else {
-            files = db.query("SELECT * FROM sandbox;");
-        }
-
-        int i = 0;
-        for (const auto& it : files) {
-            if (filter.begin != -1 && i < filter.begin) {
-                continue;
-            } else if (filter.end != -1 && i > filter.end) {
-                break;
-            }
-
-            try {
-                files_json = nlohmann::json::parse(it.at("json"));
-            } catch (const std::exception&) {
-                continue;
-            }
+        // rating_sum and rating_count are kept up to date by ff::set_rating()
+        const auto add_counts = [](nlohmann::json& file, const std::unordered_map<std::string, std::string>& it) -> void {
+            const int64_t rating_sum = std::stoll(it.at("rating_sum"));
+            const int64_t rating_count = std::stoll(it.at("rating_count"));
+            // truncated to an integer, which is what clients have always been sent
+            file["average_rating"] = rating_count > 0 ? rating_sum / rating_count : 0;
+            file["rating_count"] = rating_count;
+            file["ratings"] = nlohmann::json::object();
+
+            // the comments themselves are paged through /api/get_comments
+            file["comment_count"] = std::stoll(it.at("comment_count"));
+        };
 
-            if (files_json.find("meta") == files_json.end()) {
-                continue;
+        // without a search, the listing is filtered and ordered by the catalog in memory
+        const std::string search_query = ff::make_search_query(filter.search_string, db.is_postgres());
+        if (search_query.empty()) {
+            if (page.sort == ff::ListingSort::Relevance) {
+                page.sort = ff::ListingSort::Oldest;
             }
 
-            nlohmann::json meta;
             try {
-                meta = files_json.at("meta");
-            } catch (const std::exception&) {
-                return;
-            }
-
-            if (filter.accepted && files_json.find("needs_review") != files_json.end() && files_json.at("needs_review").is_boolean()) {
-                if (files_json.at("needs_review").get<bool>()) {
-                    continue;
-                }
-            }
-            if (filter.needs_review && files_json.find("needs_review") != files_json.end() && files_json.at("needs_review").is_boolean()) {
-                if (!files_json.at("needs_review").get<bool>()) {
-                    continue;
-                }
-            }
-            if (!filter.search_string.empty()) {
-                std::string full_str{};
-
-                if (meta.find("title") != meta.end() && meta.at("title").is_string()) {
-                    full_str += meta.at("title").get<std::string>();
-                }
-                if (meta.find("filename") != meta.end() && meta.at("filename").is_string()) {
-                    full_str += meta.at("filename").get<std::string>();
-                }
-                if (meta.find("author") != meta.end() && meta.at("author").is_string()) {
-                    full_str += meta.at("author").get<std::string>();
-                }
-                if (meta.find("description") != meta.end() && meta.at("description").is_string()) {
-                    full_str += meta.at("description").get<std::string>();
-                }
-                if (files_json.find("uploader") != files_json.end() && files_json.at("uploader").is_string()) {
-                    full_str += files_json.at("uploader").get<std::string>();
-                }
-
-                std::transform(full_str.begin(), full_str.end(), full_str.begin(), ::tolower);
-                std::transform(filter.search_string.begin(), filter.search_string.end(), filter.search_string.begin(), ::tolower);
-
-                if (full_str.find(filter.search_string) == std::string::npos) {
-                    continue;
-                }
-            }
-            if (!filter.title.empty()) {
-                if (meta.find("title") != meta.end() && meta.at("title").is_string()) {
-                    std::transform(filter.title.begin(), filter.title.end(), filter.title.begin(), ::tolower);
-                    std::string title{meta.at("title").get<std::string>()};
-                    std::transform(title.begin(), title.end(), title.begin(), ::tolower);
-                    if (title != filter.title) {
-                        continue;
+                const ff::CatalogPage catalog_page = ff::sandbox_catalog.select(db, filter, page);
+                ff::sandbox_catalog.for_each_row(db, catalog_page, {"rating_sum", "rating_count", "comment_count"}, [&](const std::unordered_map<std::string, std::string>& it) -> void {
+                    try {
+                        files_json = *ff::get_parsed_json_from_row("sandbox", it);
+                    } catch (const std::exception&) {
+                        return;
                     }
-                }
-            }
-            if (!filter.filename.empty()) {
-                if (meta.find("filename") != meta.end() && meta.at("filename").is_string()) {
-                    std::transform(filter.filename.begin(), filter.filename.end(), filter.filename.begin(), ::tolower);
-                    std::string filename{meta.at("filename").get<std::string>()};
-                    std::transform(filename.begin(), filename.end(), filename.begin(), ::tolower);
-                    if (filename != filter.filename) {
-                        continue;
-                    }
-                }
-            }
-            if (!filter.uploader.empty()) {
-                if (files_json.find("uploader") != files_json.end() && files_json.at("uploader").is_string()) {
-                    std::transform(filter.uploader.begin(), filter.uploader.end(), filter.uploader.begin(), ::tolower);
-                    std::string uploader{files_json.at("uploader").get<std::string>()};
-                    std::transform(uploader.begin(), uploader.end(), uploader.begin(), ::tolower);
-                    if (uploader != filter.uploader) {
-                        continue;
-                    }
-                }
-            }
-            if (!filter.author.empty()) {
-                if (meta.find("author") != meta.end() && meta.at("author").is_string()) {
-                    std::transform(filter.author.begin(), filter.author.end(), filter.author.begin(), ::tolower);
-                    std::string author{meta.at("author").get<std::string>()};
-                    std::transform(author.begin(), author.end(), author.begin(), ::tolower);
-                    if (author != filter.author) {
-                        continue;
-                    }
-                }
-            }
-            if (!filter.categories.empty()) {
-                bool found = false;
-                for (const auto& category : filter.categories) {
-                    if (meta.find("categories") != meta.end() && meta.at("categories").is_array()) {
-                        for (const auto& it_category : meta.at("categories")) {
-                            if (it_category.is_string()) {
-                                std::string cat{it_category.get<std::string>()};
-                                std::transform(cat.begin(), cat.end(), cat.begin(), ::tolower);
-                                if (cat == category) {
-                                    found = true;
-                                    break;
-                                }
-                            }
-                        }
-
-                        if (found) break;
-                    }
-                }
 
-                if (!found) {
-                    continue;
-                }
-            }
-            if (filter.submitted_before != -1) {
-                if (files_json.find("submitted") != files_json.end() && files_json.at("submitted").is_number_integer()) {
-                    if (files_json.at("submitted").get<int64_t>() > filter.submitted_before) {
-                        continue;
-                    }
-                }
-            }
-            if (filter.submitted_after != -1) {
-                if (files_json.find("submitted") != files_json.end() && files_json.at("submitted").is_number_integer()) {
-                    if (files_json.at("submitted").get<int64_t>() < filter.submitted_after) {
-                        continue;
-                    }
-                }
-            }
-            if (filter.submitted_between.first != -1 && filter.submitted_between.second != -1) {
-                if (files_json.find("submitted") != files_json.end() && files_json.at("submitted").is_number_integer()) {
-                    if (files_json.at("submitted").get<int64_t>() < filter.submitted_between.first || files_json.at("submitted").get<int64_t>() > filter.submitted_between.second) {
-                        continue;
-                    }
+                    add_counts(files_json, it);
+                    json["files"].push_back(files_json);
+                });
+
+                if (!catalog_page.next_cursor.empty()) {
+                    json["next_cursor"] = catalog_page.next_cursor;
                 }
+
+                return;
+            } catch (const std::exception& e) {
+                logger.write_to_log(limhamn::logger::type::error, "Failed to filter the sandbox catalog: " + std::string(e.what()) + "\n");
+                json["files"] = nlohmann::json::array();
             }
+        }
 
-            // replace [ratings] with a single average integer from [ratings][username][rating]
-            if (files_json.find("ratings") != files_json.end() && files_json.at("ratings").is_object()) {
-                int total_rating = 0;
-                int count = 0;
+        // everything but the filename and categories is filtered by the database, on the listing columns; see ff::ListingFilter
+        std::vector<ff::DatabaseParameter> parameters{};
+        const std::string where = filter.get_where(parameters);
 
-                for (const auto& _it : files_json.at("ratings").items()) {
-                    if (_it.value().at("rating").is_number_integer()) {
-                        total_rating += _it.value().at("rating").get<int>();
-                        ++count;
-                    }
-                }
+        // searches run against the full-text index, which also ranks the results
+        std::string from{"sandbox"};
+        if (!search_query.empty()) {
+            from = ff::get_search_source("sandbox", db.is_postgres());
+            parameters.insert(parameters.begin(), search_query);
+        }
 
-                if (count > 0) {
-                    files_json["average_rating"] = total_rating / count;
-                    files_json["rating_count"] = count;
-                    files_json["ratings"] = nlohmann::json::object();
-                } else {
-                    files_json["average_rating"] = 0;
-                    files_json["rating_count"] = 0;
-                    files_json["ratings"] = nlohmann::json::object();
-                }
-            } else {
-                files_json["average_rating"] = 0;
-                files_json["rating_count"] = 0;
-                files_json["ratings"] = nlohmann::json::object();
+        int skipped{0};
+        const std::string next_cursor = ff::for_each_row_in_page(db, from, {"version", "rating_sum", "rating_count", "comment_count"}, where, parameters, page, [&](const std::unordered_map<std::string, std::string>& it) -> bool {
+            try {
+                files_json = *ff::get_parsed_json_from_row("sandbox", it);
+            } catch (const std::exception&) {
+                return false;
+            }
+
+            // the categories and filename are only in the JSON
+            if (!filter.matches(ff::get_listing_document(files_json))) {
+                return false;
+            }
+
+            // begin and end predate cursors; end is turned into the page limit
+            if (filter.begin > 0 && skipped < filter.begin) {
+                ++skipped;
+                return false;
             }
 
+            add_counts(files_json, it);
             json["files"].push_back(files_json);
-            ++i;
+            return true;
+        });
+
+        if (!next_cursor.empty()) {
+            json["next_cursor"] = next_cursor;
         }
     };
 
@@ -1354,10 +1217,7 @@ limhamn::http::server::response ff::handle_api_set_approval_for_uploads_endpoint
         // get json from db
         try {
             if (accepted) {
-                nlohmann::json json;
-                try {
-                    json = nlohmann::json::parse(ff::get_json_from_table(db, "forwarders", "identifier", identifier));
-                } catch (const std::exception&) {
+                if (!ff::patch_json_in_table(db, "forwarders", "identifier", identifier, {{ff::JsonPatchOperation::Set, {"needs_review"}, false}})) {
                     nlohmann::json _json;
                     _json["error_str"] = "Invalid JSON received";
                     _json["error"] = "FF_INVALID_JSON";
@@ -1365,11 +1225,11 @@ limhamn::http::server::response ff::handle_api_set_approval_for_uploads_endpoint
                     response.body = _json.dump();
                     return response;
                 }
-
-                json["needs_review"] = false;
-                ff::set_json_in_table(db, "forwarders", "identifier", identifier, json.dump());
             } else {
                 db.exec("DELETE FROM forwarders WHERE identifier = ?;", identifier);
+                db.exec("DELETE FROM ratings WHERE kind = ? AND identifier = ?;", "forwarders", identifier);
+                db.exec("DELETE FROM comments WHERE kind = ? AND identifier = ?;", "forwarders", identifier);
+                ff::touch_catalog(db, "forwarders");
             }
         } catch (const std::exception&) {
 #if FF_DEBUG
@@ -1392,10 +1252,7 @@ limhamn::http::server::response ff::handle_api_set_approval_for_uploads_endpoint
 
         try {
             if (accepted) {
-                nlohmann::json json;
-                try {
-                    json = nlohmann::json::parse(ff::get_json_from_table(db, "sandbox", "identifier", identifier));
-                } catch (const std::exception&) {
+                if (!ff::patch_json_in_table(db, "sandbox", "identifier", identifier, {{ff::JsonPatchOperation::Set, {"needs_review"}, false}})) {
                     nlohmann::json _json;
                     _json["error_str"] = "Invalid JSON received";
                     _json["error"] = "FF_INVALID_JSON";
@@ -1403,11 +1260,11 @@ limhamn::http::server::response ff::handle_api_set_approval_for_uploads_endpoint
                     response.body = _json.dump();
                     return response;
                 }
-
-                json["needs_review"] = false;
-                ff::set_json_in_table(db, "sandbox", "identifier", identifier, json.dump());
             } else {
                 db.exec("DELETE FROM sandbox WHERE identifier = ?;", identifier);
+                db.exec("DELETE FROM ratings WHERE kind = ? AND identifier = ?;", "sandbox", identifier);
+                db.exec("DELETE FROM comments WHERE kind = ? AND identifier = ?;", "sandbox", identifier);
+                ff::touch_catalog(db, "sandbox");
             }
         } catch (const std::exception&) {
 #if FF_DEBUG
@@ -1538,31 +1395,50 @@ limhamn::http::server::response ff::handle_api_get_profile_endpoint(const limham
         return response;
     }
 
+    std::sort(usernames.begin(), usernames.end());
+    usernames.erase(std::unique(usernames.begin(), usernames.end()), usernames.end());
+
+    const auto add_profile = [&response_json](const std::string& username, const ff::Profile& profile) -> void {
+        response_json["users"][username]["display_name"] = profile.display_name;
+        response_json["users"][username]["description"] = profile.description;
+        response_json["users"][username]["profile_key"] = profile.profile_key;
+    };
+
+    std::vector<std::string> missing{};
     for (const auto& it : usernames) {
-        try {
-            const auto _json = nlohmann::json::parse(ff::get_json_from_table(db, "users", "username", it));
-            if (!_json.contains("profile") || !_json.at("profile").is_object()) {
-                continue;
-            }
-            const auto& json = _json.at("profile");
-            if (json.contains("display_name") && json.at("display_name").is_string()) {
-                response_json["users"][it]["display_name"] = json.at("display_name").get<std::string>();
-            } else {
-                response_json["users"][it]["display_name"] = it;
-            }
-            if (json.contains("description") && json.at("description").is_string()) {
-                response_json["users"][it]["description"] = json.at("description").get<std::string>();
-            } else {
-                response_json["users"][it]["description"] = "";
-            }
-            if (json.contains("profile_key") && json.at("profile_key").is_string()) {
-                response_json["users"][it]["profile_key"] = json.at("profile_key").get<std::string>();
-            } else {
-                response_json["users"][it]["profile_key"] = "";
-            }
-        } catch (const std::exception& e) {
-            ff::logger.write_to_log(limhamn::logger::type::error, "Failed to get profile for user: " + it + ". Error: " + e.what() + "\n");
-            continue;
+        if (const auto profile = ff::profile_cache.find(it)) {
+            add_profile(it, *profile);
+        } else {
+            missing.push_back(it);
+        }
+    }
+
+    // the rest are read from the profile columns, a batch per query; the number of placeholders is rounded
+    // up to a power of two by repeating the last name, so only a few distinct statements are ever prepared
+    constexpr std::size_t max_batch{64};
+    for (std::size_t begin{0}; begin < missing.size(); begin += max_batch) {
+        const std::size_t count = std::min(max_batch, missing.size() - begin);
+        std::size_t placeholders{1};
+        while (placeholders < count) {
+            placeholders *= 2;
+        }
+
+        std::string query{"SELECT username, display_name, description, profile_key FROM users WHERE username IN ("};
+        std::vector<ff::DatabaseParameter> parameters{};
+        for (std::size_t i{0}; i < placeholders; ++i) {
+            query += i == 0 ? "?" : ", ?";
+            parameters.emplace_back(missing[begin + std::min(i, count - 1)]);
+        }
+        query += ");";
+
+        for (const auto& it : db.query(query, parameters)) {
+            ff::Profile profile{};
+            profile.display_name = it.at("display_name").empty() ? it.at("username") : it.at("display_name");
+            profile.description = it.at("description");
+            profile.profile_key = it.at("profile_key");
+
+            ff::profile_cache.insert(it.at("username"), profile);
+            add_profile(it.at("username"), profile);
         }
     }
 
@@ -1743,7 +1619,7 @@ limhamn::http::server::response ff::handle_api_create_announcement_endpoint(cons
 
     db_json["announcements"].push_back(announcement);
 
-    db.exec("UPDATE general SET json = ? WHERE id = 1", db_json.dump());
+    db.exec("UPDATE general SET json = ?, version = version + 1 WHERE id = 1", db_json.dump());
 
     response.http_status = 201;
     return response;
@@ -1966,7 +1842,7 @@ limhamn::http::server::response ff::handle_api_delete_announcement(const limhamn
             }
             announcements.erase(announcements.begin() + announcement_id);
         }
-        db.exec("UPDATE general SET json = ? WHERE id = 1", json.dump());
+        db.exec("UPDATE general SET json = ?, version = version + 1 WHERE id = 1", json.dump());
         response.http_status = 204;
         return response;
     } catch (const std::exception&) {
@@ -2157,7 +2033,7 @@ limhamn::http::server::response ff::handle_api_edit_announcement_endpoint(const
             }
             announcement["author"] = username;
         }
-        db.exec("UPDATE general SET json = ? WHERE id = 1", json.dump());
+        db.exec("UPDATE general SET json = ?, version = version + 1 WHERE id = 1", json.dump());
         response.http_status = 204;
         return response;
     } catch (const std::exception&) {
@@ -2291,10 +2167,19 @@ limhamn::http::server::response ff::handle_api_rate_file_endpoint(const limhamn:
         return response;
     }
 
-    nlohmann::json db_json;
+    bool found{false};
     try {
-        db_json = nlohmann::json::parse(ff::get_json_from_table(db, "sandbox", "identifier", file_identifier));
-    } catch (const std::exception&) {
+        found = ff::set_rating(db, "sandbox", file_identifier, username, rating);
+    } catch (const std::exception& e) {
+        nlohmann::json ret;
+        ret["error_str"] = "Failed to rate: " + std::string(e.what());
+        ret["error"] = "FF_DATABASE_ERROR";
+        response.http_status = 500;
+        response.body = ret.dump();
+        return response;
+    }
+
+    if (!found) {
         nlohmann::json ret;
         ret["error_str"] = "File not found";
         ret["error"] = "FF_FILE_NOT_FOUND";
@@ -2303,20 +2188,6 @@ limhamn::http::server::response ff::handle_api_rate_file_endpoint(const limhamn:
         return response;
     }
 
-    // db_json["ratings"]["username"]["rating"] = rating;
-    if (db_json.find("ratings") == db_json.end() || !db_json.at("ratings").is_object()) {
-        db_json["ratings"] = nlohmann::json::object();
-    }
-    if (rating == 0) {
-        // remove the rating for the user
-        db_json["ratings"].erase(username);
-    } else {
-        // set the rating for the user
-        db_json["ratings"][username]["rating"] = rating;
-    }
-
-    ff::set_json_in_table(db, "sandbox", "identifier", file_identifier, db_json.dump());
-
     response.http_status = 204;
     response.body = "";
     return response;
@@ -2439,10 +2310,19 @@ limhamn::http::server::response ff::handle_api_rate_forwarder_endpoint(const lim
         return response;
     }
 
-    nlohmann::json db_json;
+    bool found{false};
     try {
-        db_json = nlohmann::json::parse(ff::get_json_from_table(db, "forwarders", "identifier", forwarder_identifier));
-    } catch (const std::exception&) {
+        found = ff::set_rating(db, "forwarders", forwarder_identifier, username, rating);
+    } catch (const std::exception& e) {
+        nlohmann::json ret;
+        ret["error_str"] = "Failed to rate: " + std::string(e.what());
+        ret["error"] = "FF_DATABASE_ERROR";
+        response.http_status = 500;
+        response.body = ret.dump();
+        return response;
+    }
+
+    if (!found) {
         nlohmann::json ret;
         ret["error_str"] = "File not found";
         ret["error"] = "FF_FILE_NOT_FOUND";
@@ -2451,20 +2331,6 @@ limhamn::http::server::response ff::handle_api_rate_forwarder_endpoint(const lim
         return response;
     }
 
-    // db_json["ratings"]["username"]["rating"] = rating;
-    if (db_json.find("ratings") == db_json.end() || !db_json.at("ratings").is_object()) {
-        db_json["ratings"] = nlohmann::json::object();
-    }
-    if (rating == 0) {
-        // remove the rating for the user
-        db_json["ratings"].erase(username);
-    } else {
-        // set the rating for the user
-        db_json["ratings"][username]["rating"] = rating;
-    }
-
-    ff::set_json_in_table(db, "forwarders", "identifier", forwarder_identifier, db_json.dump());
-
     response.http_status = 204;
     response.body = "";
     return response;
@@ -2585,18 +2451,19 @@ limhamn::http::server::response ff::handle_api_comment_forwarder_endpoint(const
         return response;
     }
 
-    nlohmann::json db_json;
+    bool found{false};
     try {
-        db_json = nlohmann::json::parse(ff::get_json_from_table(db, "forwarders", "identifier", forwarder_identifier));
-    } catch (const std::exception&) {
+        found = ff::insert_comment(db, "forwarders", forwarder_identifier, username, limhamn::http::utils::htmlspecialchars(comment_text));
+    } catch (const std::exception& e) {
         nlohmann::json ret;
-        ret["error_str"] = "Forwarder not found";
-        ret["error"] = "FF_FORWARDER_NOT_FOUND";
-        response.http_status = 404;
+        ret["error_str"] = "Failed to comment: " + std::string(e.what());
+        ret["error"] = "FF_DATABASE_ERROR";
+        response.http_status = 500;
         response.body = ret.dump();
         return response;
     }
-    if (db_json.empty()) {
+
+    if (!found) {
         nlohmann::json ret;
         ret["error_str"] = "Forwarder not found";
         ret["error"] = "FF_FORWARDER_NOT_FOUND";
@@ -2605,19 +2472,6 @@ limhamn::http::server::response ff::handle_api_comment_forwarder_endpoint(const
         return response;
     }
 
-    // db_json["reviews"]["username"]["comment"] = comment_text;
-    if (db_json.find("reviews") == db_json.end() || !db_json.at("reviews").is_array()) {
-        db_json["reviews"] = nlohmann::json::array();
-    }
-
-    db_json["reviews"].push_back({
-        {"comment", limhamn::http::utils::htmlspecialchars(comment_text)},
-        {"timestamp", scrypto::return_unix_millis()},
-        {"username", username}
-    });
-
-    ff::set_json_in_table(db, "forwarders", "identifier", forwarder_identifier, db_json.dump());
-
     response.http_status = 204;
     response.body = "";
     return response;
@@ -2738,38 +2592,27 @@ limhamn::http::server::response ff::handle_api_comment_file_endpoint(const limha
         return response;
     }
 
-    nlohmann::json db_json;
+    bool found{false};
     try {
-        db_json = nlohmann::json::parse(ff::get_json_from_table(db, "sandbox", "identifier", file_identifier));
-    } catch (const std::exception&) {
+        found = ff::insert_comment(db, "sandbox", file_identifier, username, limhamn::http::utils::htmlspecialchars(comment_text));
+    } catch (const std::exception& e) {
         nlohmann::json ret;
-        ret["error_str"] = "File not found";
-        ret["error"] = "FF_FILE_NOT_FOUND";
-        response.http_status = 404;
+        ret["error_str"] = "Failed to comment: " + std::string(e.what());
+        ret["error"] = "FF_DATABASE_ERROR";
+        response.http_status = 500;
         response.body = ret.dump();
         return response;
     }
-    if (db_json.empty()) {
+
+    if (!found) {
         nlohmann::json ret;
-        ret["error_str"] = "Forwarder not found";
-        ret["error"] = "FF_FORWARDER_NOT_FOUND";
+        ret["error_str"] = "File not found";
+        ret["error"] = "FF_FILE_NOT_FOUND";
         response.http_status = 404;
         response.body = ret.dump();
         return response;
     }
 
-    if (db_json.find("reviews") == db_json.end() || !db_json.at("reviews").is_array()) {
-        db_json["reviews"] = nlohmann::json::array();
-    }
-
-    db_json["reviews"].push_back({
-        {"comment", limhamn::http::utils::htmlspecialchars(comment_text)},
-        {"timestamp", scrypto::return_unix_millis()},
-        {"username", username}
-    });
-
-    ff::set_json_in_table(db, "sandbox", "identifier", file_identifier, db_json.dump());
-
     response.http_status = 204;
     response.body = "";
     return response;
@@ -2880,53 +2723,40 @@ limhamn::http::server::response ff::handle_api_delete_comment_forwarder_endpoint
         return response;
     }
 
-    const int comment_identifier = json.at("comment_identifier").get<int>();
+    // comment_identifier is the id of the comment, as returned by /api/get_comments
+    const int64_t comment_identifier = json.at("comment_identifier").get<int64_t>();
 
-    nlohmann::json db_json;
-    try {
-        db_json = nlohmann::json::parse(ff::get_json_from_table(db, "forwarders", "identifier", forwarder_identifier));
-    } catch (const std::exception&) {
+    const auto comment = db.query("SELECT username FROM comments WHERE id = ? AND kind = ? AND identifier = ?;", comment_identifier, "forwarders", forwarder_identifier);
+    if (comment.empty()) {
         nlohmann::json ret;
-        ret["error_str"] = "File not found";
-        ret["error"] = "FF_FILE_NOT_FOUND";
-        response.http_status = 404;
+        ret["error_str"] = "Invalid comment_identifier";
+        ret["error"] = "FF_INVALID_JSON";
+        response.http_status = 400;
         response.body = ret.dump();
         return response;
     }
-    if (db_json.empty()) {
+
+    // it must have the same username as the user who is trying to delete the comment OR user_type must be Administrator
+    if (comment.front().at("username") != username && get_user_type(db, username) != ff::UserType::Administrator) {
         nlohmann::json ret;
-        ret["error_str"] = "Forwarder not found";
-        ret["error"] = "FF_FORWARDER_NOT_FOUND";
-        response.http_status = 404;
+        ret["error_str"] = "You can only delete your own comments";
+        ret["error"] = "FF_NOT_AUTHORIZED";
+        response.http_status = 403;
         response.body = ret.dump();
         return response;
     }
 
-    auto& reviews = db_json["reviews"];
-    if (reviews.is_array() && comment_identifier >= 0 && comment_identifier < static_cast<int>(reviews.size())) {
-        // it must have the same username as the user who is trying to delete the comment OR user_type must be Administrator
-        if ((reviews[comment_identifier].find("username") == reviews[comment_identifier].end() ||
-            reviews[comment_identifier].at("username").get<std::string>() != username) && get_user_type(db, username) != ff::UserType::Administrator) {
-            nlohmann::json ret;
-            ret["error_str"] = "You can only delete your own comments";
-            ret["error"] = "FF_NOT_AUTHORIZED";
-            response.http_status = 403;
-            response.body = ret.dump();
-            return response;
-        }
-
-        reviews.erase(reviews.begin() + comment_identifier);
-    } else {
+    try {
+        ff::delete_comment(db, "forwarders", forwarder_identifier, comment_identifier);
+    } catch (const std::exception& e) {
         nlohmann::json ret;
-        ret["error_str"] = "Invalid comment_identifier";
-        ret["error"] = "FF_INVALID_JSON";
-        response.http_status = 400;
+        ret["error_str"] = "Failed to delete comment: " + std::string(e.what());
+        ret["error"] = "FF_DATABASE_ERROR";
+        response.http_status = 500;
         response.body = ret.dump();
         return response;
     }
 
-    ff::set_json_in_table(db, "forwarders", "identifier", forwarder_identifier, db_json.dump());
-
     response.http_status = 204;
     response.body = "";
     return response;
@@ -3037,55 +2867,121 @@ limhamn::http::server::response ff::handle_api_delete_comment_file_endpoint(cons
         return response;
     }
 
-    const int comment_identifier = json.at("comment_identifier").get<int>();
+    // comment_identifier is the id of the comment, as returned by /api/get_comments
+    const int64_t comment_identifier = json.at("comment_identifier").get<int64_t>();
+
+    const auto comment = db.query("SELECT username FROM comments WHERE id = ? AND kind = ? AND identifier = ?;", comment_identifier, "sandbox", file_identifier);
+    if (comment.empty()) {
+        nlohmann::json ret;
+        ret["error_str"] = "Invalid comment_identifier";
+        ret["error"] = "FF_INVALID_JSON";
+        response.http_status = 400;
+        response.body = ret.dump();
+        return response;
+    }
+
+    // it must have the same username as the user who is trying to delete the comment OR user_type must be Administrator
+    if (comment.front().at("username") != username && get_user_type(db, username) != ff::UserType::Administrator) {
+        nlohmann::json ret;
+        ret["error_str"] = "You can only delete your own comments";
+        ret["error"] = "FF_NOT_AUTHORIZED";
+        response.http_status = 403;
+        response.body = ret.dump();
+        return response;
+    }
 
-    nlohmann::json db_json;
     try {
-        db_json = nlohmann::json::parse(ff::get_json_from_table(db, "sandbox", "identifier", file_identifier));
-    } catch (const std::exception&) {
+        ff::delete_comment(db, "sandbox", file_identifier, comment_identifier);
+    } catch (const std::exception& e) {
         nlohmann::json ret;
-        ret["error_str"] = "File not found";
-        ret["error"] = "FF_FILE_NOT_FOUND";
-        response.http_status = 404;
+        ret["error_str"] = "Failed to delete comment: " + std::string(e.what());
+        ret["error"] = "FF_DATABASE_ERROR";
+        response.http_status = 500;
         response.body = ret.dump();
         return response;
     }
-    if (db_json.empty()) {
+
+    response.http_status = 204;
+    response.body = "";
+    return response;
+}
+
+limhamn::http::server::response ff::handle_api_get_comments_endpoint(const limhamn::http::server::request& request, database& db) {
+    limhamn::http::server::response response{};
+    response.content_type = "application/json";
+
+    nlohmann::json json;
+    try {
+        json = nlohmann::json::parse(request.body);
+    } catch (const std::exception&) {
         nlohmann::json ret;
-        ret["error_str"] = "File not found";
-        ret["error"] = "FF_FILE_NOT_FOUND";
-        response.http_status = 404;
+        ret["error_str"] = "Invalid JSON";
+        ret["error"] = "FF_INVALID_JSON";
+        response.http_status = 400;
         response.body = ret.dump();
         return response;
     }
 
-    auto& reviews = db_json["reviews"];
-    if (reviews.is_array() && comment_identifier >= 0 && comment_identifier < static_cast<int>(reviews.size())) {
-        // it must have the same username as the user who is trying to delete the comment OR user_type must be Administrator
-        if ((reviews[comment_identifier].find("username") == reviews[comment_identifier].end() ||
-            reviews[comment_identifier].at("username").get<std::string>() != username) && get_user_type(db, username) != ff::UserType::Administrator) {
-            nlohmann::json ret;
-            ret["error_str"] = "You can only delete your own comments";
-            ret["error"] = "FF_NOT_AUTHORIZED";
-            response.http_status = 403;
-            response.body = ret.dump();
-            return response;
-        }
+    std::string table{};
+    std::string identifier{};
+    if (json.contains("forwarder_identifier") && json.at("forwarder_identifier").is_string()) {
+        table = "forwarders";
+        identifier = json.at("forwarder_identifier").get<std::string>();
+    } else if (json.contains("file_identifier") && json.at("file_identifier").is_string()) {
+        table = "sandbox";
+        identifier = json.at("file_identifier").get<std::string>();
+    }
 
-        reviews.erase(reviews.begin() + comment_identifier);
-    } else {
+    if (identifier.empty()) {
         nlohmann::json ret;
-        ret["error_str"] = "Invalid comment_identifier";
+        ret["error_str"] = "forwarder_identifier or file_identifier is required";
         ret["error"] = "FF_INVALID_JSON";
         response.http_status = 400;
         response.body = ret.dump();
         return response;
     }
 
-    ff::set_json_in_table(db, "sandbox", "identifier", file_identifier, db_json.dump());
+    ff::PageRequest page{};
+    try {
+        page = ff::parse_page_request(json, false);
+    } catch (const std::invalid_argument& e) {
+        nlohmann::json ret;
+        ret["error_str"] = e.what();
+        ret["error"] = "FF_INVALID_JSON";
+        response.http_status = 400;
+        response.body = ret.dump();
+        return response;
+    }
 
-    response.http_status = 204;
-    response.body = "";
+    // comments are only ever handed out a page at a time
+    if (page.limit == 0) {
+        page.limit = std::max<std::size_t>(ff::settings.max_page_size, 1);
+    }
+
+    nlohmann::json ret;
+    ret["comments"] = nlohmann::json::array();
+    ret["next_cursor"] = nullptr;
+
+    const std::string next_cursor = ff::for_each_row_in_page(db, "comments", {}, " WHERE kind = ? AND identifier = ?", {table, identifier}, page,
+        [&](const std::unordered_map<std::string, std::string>& it) -> bool {
+        nlohmann::json comment;
+        try {
+            comment = nlohmann::json::parse(it.at("json"));
+        } catch (const std::exception&) {
+            return false;
+        }
+
+        comment["id"] = std::stoll(it.at("id"));
+        ret["comments"].push_back(comment);
+        return true;
+    });
+
+    if (!next_cursor.empty()) {
+        ret["next_cursor"] = next_cursor;
+    }
+
+    response.http_status = 200;
+    response.body = ret.dump();
     return response;
 }
 
@@ -3178,7 +3074,7 @@ limhamn::http::server::response ff::handle_api_delete_file_endpoint(const limham
     const std::string& file_identifier = json.at("file_identifier").get<std::string>();
 
     try {
-        nlohmann::json db_json = nlohmann::json::parse(ff::get_json_from_table(db, "sandbox", "identifier", file_identifier));
+        nlohmann::json db_json = *ff::get_parsed_json_from_table(db, "sandbox", "identifier", file_identifier);
         const auto& uploader = db_json.at("uploader").get<std::string>();
         if (username != uploader && get_user_type(db, username) != ff::UserType::Administrator) {
             nlohmann::json ret;
@@ -3190,6 +3086,9 @@ limhamn::http::server::response ff::handle_api_delete_file_endpoint(const limham
         }
 
         db.exec("DELETE FROM sandbox WHERE identifier = ?", file_identifier);
+        db.exec("DELETE FROM ratings WHERE kind = ? AND identifier = ?;", "sandbox", file_identifier);
+        db.exec("DELETE FROM comments WHERE kind = ? AND identifier = ?;", "sandbox", file_identifier);
+        ff::touch_catalog(db, "sandbox");
     } catch (const std::exception&) {
         nlohmann::json ret;
         ret["error_str"] = "File not found";
@@ -3293,7 +3192,7 @@ limhamn::http::server::response ff::handle_api_delete_forwarder_endpoint(const l
     const std::string& forwarder_identifier = json.at("forwarder_identifier").get<std::string>();
 
     try {
-        nlohmann::json db_json = nlohmann::json::parse(ff::get_json_from_table(db, "forwarders", "identifier", forwarder_identifier));
+        nlohmann::json db_json = *ff::get_parsed_json_from_table(db, "forwarders", "identifier", forwarder_identifier);
         const auto& uploader = db_json.at("uploader").get<std::string>();
         if (username != uploader && get_user_type(db, username) != ff::UserType::Administrator) {
             nlohmann::json ret;
@@ -3305,6 +3204,9 @@ limhamn::http::server::response ff::handle_api_delete_forwarder_endpoint(const l
         }
 
         db.exec("DELETE FROM forwarders WHERE identifier = ?", forwarder_identifier);
+        db.exec("DELETE FROM ratings WHERE kind = ? AND identifier = ?;", "forwarders", forwarder_identifier);
+        db.exec("DELETE FROM comments WHERE kind = ? AND identifier = ?;", "forwarders", forwarder_identifier);
+        ff::touch_catalog(db, "forwarders");
     } catch (const std::exception&) {
         nlohmann::json ret;
         ret["error_str"] = "File not found";
@@ -3370,9 +3272,13 @@ limhamn::http::server::response ff::handle_api_stay_logged_in(const limhamn::htt
     return response;
 }
 
-limhamn::http::server::response ff::handle_api_try_logout_endpoint(const limhamn::http::server::request&, database&) {
+limhamn::http::server::response ff::handle_api_try_logout_endpoint(const limhamn::http::server::request& request, database&) {
     limhamn::http::server::response response{};
 
+    if (request.session.find("username") != request.session.end()) {
+        session_cache.invalidate(request.session.at("username"));
+    }
+
     response.content_type = "application/json";
     response.http_status = 204;
     response.body = "";
@@ -3487,7 +3393,7 @@ limhamn::http::server::response ff::handle_api_create_topic_endpoint(const limha
 
     const auto check_if_topic_exists = [&db, &topic_id]() -> bool {
         try {
-            nlohmann::json db_json = nlohmann::json::parse(ff::get_json_from_table(db, "topics", "identifier", topic_id));
+            nlohmann::json db_json = *ff::get_parsed_json_from_table(db, "topics", "identifier", topic_id);
             return !db_json.empty();
         } catch (const std::exception&) {
             return false;
@@ -3522,24 +3428,14 @@ limhamn::http::server::response ff::handle_api_create_topic_endpoint(const limha
 	// this identifier should then be added to the "topics" array of each parent topic
 	if (json.contains("parent_topics") && json.at("parent_topics").is_array()) {
         for (const auto& parent_topic : json.at("parent_topics")) {
-            if (parent_topic.is_string()) {
-                try {
-                    nlohmann::json parent_json = nlohmann::json::parse(ff::get_json_from_table(db, "topics", "identifier", parent_topic.get<std::string>()));
-                    if (!parent_json.empty()) {
-                        if (parent_json.find("topics") == parent_json.end() || !parent_json.at("topics").is_array()) {
-                            parent_json["topics"] = nlohmann::json::array();
-                        }
-                        parent_json["topics"].push_back(topic_id);
-                        ff::set_json_in_table(db, "topics", "identifier", parent_topic.get<std::string>(), parent_json.dump());
-                    }
-                } catch (const std::exception&) {
-                	nlohmann::json ret;
-                    ret["error_str"] = "Parent topic not found: " + parent_topic.get<std::string>();
-                    ret["error"] = "FF_TOPIC_NOT_FOUND";
-                    response.http_status = 404;
-                    response.body = ret.dump();
-                    return response;
-                }
+            if (parent_topic.is_string() &&
+                !ff::patch_json_in_table(db, "topics", "identifier", parent_topic.get<std::string>(), {{ff::JsonPatchOperation::Append, {"topics"}, topic_id}})) {
+                nlohmann::json ret;
+                ret["error_str"] = "Parent topic not found: " + parent_topic.get<std::string>();
+                ret["error"] = "FF_TOPIC_NOT_FOUND";
+                response.http_status = 404;
+                response.body = ret.dump();
+                return response;
             }
         }
     }
@@ -3668,7 +3564,7 @@ limhamn::http::server::response ff::handle_api_delete_topic_endpoint(const limha
     }
 
 	try {
-		const auto db_json = nlohmann::json::parse(ff::get_json_from_table(db, "topics", "identifier", topic_id));
+		const auto db_json = *ff::get_parsed_json_from_table(db, "topics", "identifier", topic_id);
 		if (db_json.empty()) {
 			nlohmann::json ret;
 			ret["error_str"] = "Topic not found";
@@ -3727,6 +3623,7 @@ limhamn::http::server::response ff::handle_api_get_topics_endpoint(const limhamn
 
 	int start_index{};
 	int end_index = -1;
+	ff::PageRequest page{};
 	std::vector<std::string> ids{};
 
     try {
@@ -3747,37 +3644,57 @@ limhamn::http::server::response ff::handle_api_get_topics_endpoint(const limhamn
         if (input_json.contains("end_index") && input_json.at("end_index").is_number_integer()) {
             end_index = input_json.at("end_index").get<int>();
         }
+
+        page = ff::parse_page_request(input_json, false);
+    } catch (const std::invalid_argument& e) {
+        nlohmann::json ret;
+        ret["error_str"] = "Invalid pagination: " + std::string(e.what());
+        ret["error"] = "FF_INVALID_JSON";
+        response.http_status = 400;
+        response.body = ret.dump();
+        return response;
     } catch (const std::exception&) {}
 
+    // start_index and end_index predate cursors; end_index is turned into the page limit
+    if (page.limit == 0 && end_index >= 0) {
+        page.limit = static_cast<std::size_t>(std::max(end_index - std::max(start_index, 0) + 1, 1));
+    }
+
 	nlohmann::json json;
 
 	json["topics"] = nlohmann::json::array();
+	json["next_cursor"] = nullptr;
 
     try {
-    	auto contents = db.query("SELECT * FROM topics");
-
-    	int i{};
-    	for (const auto& it : contents) {
-    		if (i < start_index) {
-    			++i;
-    			continue;
-    		}
-    		if (end_index >= 0 && i > end_index) {
-    			break;
-    		}
+    	std::string where{};
+    	std::vector<ff::DatabaseParameter> parameters{};
+    	for (const auto& it : ids) {
+    		where += (where.empty() ? " WHERE identifier IN (?" : ", ?");
+    		parameters.emplace_back(it);
+    	}
+    	if (!where.empty()) {
+    		where += ")";
+    	}
 
-    		const auto db_json = nlohmann::json::parse(it.at("json"));
+    	int skipped{0};
+    	const std::string next_cursor = ff::for_each_row_in_page(db, "topics", {"version"}, where, parameters, page, [&](const std::unordered_map<std::string, std::string>& it) -> bool {
+    		const auto parsed = ff::get_parsed_json_from_row("topics", it);
+    		const auto& db_json = *parsed;
 
     		if (!db_json.contains("identifier") || !db_json.at("identifier").is_string()) {
-    			continue;
+    			return false;
     		}
-
-    		if (!ids.empty() && std::find(ids.begin(), ids.end(), db_json.at("identifier").get<std::string>()) == ids.end()) {
-    			continue; // skip if the identifier is not in the list of ids
+    		if (skipped < start_index) {
+    			++skipped;
+    			return false;
     		}
 
     		json["topics"].push_back(db_json);
-    		++i;
+    		return true;
+    	});
+
+    	if (!next_cursor.empty()) {
+    		json["next_cursor"] = next_cursor;
     	}
     } catch (const std::exception& e) {
         nlohmann::json ret;
@@ -3897,7 +3814,7 @@ limhamn::http::server::response ff::handle_api_close_topic_endpoint(const limham
 	}
 
     try {
-        nlohmann::json db_json = nlohmann::json::parse(ff::get_json_from_table(db, "topics", "identifier", topic_id));
+        nlohmann::json db_json = *ff::get_parsed_json_from_table(db, "topics", "identifier", topic_id);
         if (db_json.empty()) {
             nlohmann::json ret;
             ret["error_str"] = "Topic not found";
@@ -3917,9 +3834,7 @@ limhamn::http::server::response ff::handle_api_close_topic_endpoint(const limham
             return response;
         }
 
-        db_json["open"] = open;
-
-        ff::set_json_in_table(db, "topics", "identifier", topic_id, db_json.dump());
+        ff::patch_json_in_table(db, "topics", "identifier", topic_id, {{ff::JsonPatchOperation::Set, {"open"}, open}});
     } catch (const std::exception&) {
 	    nlohmann::json ret;
     	ret["error_str"] = "Topic not found";
@@ -4033,7 +3948,7 @@ limhamn::http::server::response ff::handle_api_edit_topic_endpoint(const limhamn
 	}
 
 	try {
-		nlohmann::json db_json = nlohmann::json::parse(ff::get_json_from_table(db, "topics", "identifier", topic_id));
+		nlohmann::json db_json = *ff::get_parsed_json_from_table(db, "topics", "identifier", topic_id);
 		if (db_json.empty()) {
 			nlohmann::json ret;
 			ret["error_str"] = "Topic not found";
@@ -4053,14 +3968,15 @@ limhamn::http::server::response ff::handle_api_edit_topic_endpoint(const limhamn
             return response;
         }
 
+		std::vector<ff::JsonPatch> patches{};
 		if (json.contains("title") && json.at("title").is_string()) {
-            db_json["title"] = limhamn::http::utils::htmlspecialchars(json.at("title").get<std::string>());
+            patches.push_back({ff::JsonPatchOperation::Set, {"title"}, limhamn::http::utils::htmlspecialchars(json.at("title").get<std::string>())});
         }
 		if (json.contains("description") && json.at("description").is_string()) {
-            db_json["description"] = limhamn::http::utils::htmlspecialchars(json.at("description").get<std::string>());
+            patches.push_back({ff::JsonPatchOperation::Set, {"description"}, limhamn::http::utils::htmlspecialchars(json.at("description").get<std::string>())});
         }
 
-		ff::set_json_in_table(db, "topics", "identifier", topic_id, db_json.dump());
+		ff::patch_json_in_table(db, "topics", "identifier", topic_id, patches);
 	} catch (const std::exception&) {
 		nlohmann::json ret;
 		ret["error_str"] = "Topic not found";
@@ -4172,7 +4088,7 @@ limhamn::http::server::response ff::handle_api_delete_post_endpoint(const limham
 
 	const auto check_if_post_exists = [&db, &post_id]() -> bool {
         try {
-            nlohmann::json db_json = nlohmann::json::parse(ff::get_json_from_table(db, "posts", "identifier", post_id));
+            nlohmann::json db_json = *ff::get_parsed_json_from_table(db, "posts", "identifier", post_id);
             return !db_json.empty();
         } catch (const std::exception&) {
             return false;
@@ -4189,7 +4105,7 @@ limhamn::http::server::response ff::handle_api_delete_post_endpoint(const limham
     }
 
 	try {
-		nlohmann::json db_json = nlohmann::json::parse(ff::get_json_from_table(db, "posts", "identifier", post_id));
+		nlohmann::json db_json = *ff::get_parsed_json_from_table(db, "posts", "identifier", post_id);
 
 		if (db_json.empty()) {
             nlohmann::json ret;
@@ -4212,7 +4128,7 @@ limhamn::http::server::response ff::handle_api_delete_post_endpoint(const limham
 
 		if (db_json.find("topic_id") != db_json.end() && db_json.at("topic_id").is_string()) {
             const std::string topic_id = db_json.at("topic_id").get<std::string>();
-            nlohmann::json topic_json = nlohmann::json::parse(ff::get_json_from_table(db, "topics", "identifier", topic_id));
+            nlohmann::json topic_json = *ff::get_parsed_json_from_table(db, "topics", "identifier", topic_id);
             if (topic_json.empty()) {
                 nlohmann::json ret;
                 ret["error_str"] = "Topic not found";
@@ -4231,13 +4147,18 @@ limhamn::http::server::response ff::handle_api_delete_post_endpoint(const limham
                 return response;
             }
 
-			auto& posts = topic_json["posts"];
-            posts.erase(std::remove_if(posts.begin(), posts.end(),
-                [&post_id](const nlohmann::json& post) {
-                    return post.contains("identifier") && post.at("identifier").get<std::string>() == post_id;
-                }), posts.end());
+            ff::update_json_in_table(db, "topics", "identifier", topic_id, [&post_id](nlohmann::json& current) -> bool {
+                if (!current.contains("posts") || !current.at("posts").is_array()) {
+                    return false;
+                }
 
-            ff::set_json_in_table(db, "topics", "identifier", topic_id, topic_json.dump());
+                auto& posts = current.at("posts");
+                posts.erase(std::remove_if(posts.begin(), posts.end(),
+                    [&post_id](const nlohmann::json& post) {
+                        return post.contains("identifier") && post.at("identifier").get<std::string>() == post_id;
+                    }), posts.end());
+                return true;
+            });
         }
 
 		// now delete the post
@@ -4361,7 +4282,7 @@ limhamn::http::server::response ff::handle_api_close_post_endpoint(const limhamn
     }
 
 	try {
-		nlohmann::json db_json = nlohmann::json::parse(ff::get_json_from_table(db, "posts", "identifier", post_id));
+		nlohmann::json db_json = *ff::get_parsed_json_from_table(db, "posts", "identifier", post_id);
 		if (db_json.empty()) {
 			nlohmann::json ret;
 			ret["error_str"] = "Post not found";
@@ -4382,7 +4303,7 @@ limhamn::http::server::response ff::handle_api_close_post_endpoint(const limhamn
         }
 
 		if (db_json.find("topic_id") != db_json.end() && db_json.at("topic_id").is_string()) {
-			nlohmann::json topic_json = nlohmann::json::parse(ff::get_json_from_table(db, "topics", "identifier", db_json.at("topic_id").get<std::string>()));
+			nlohmann::json topic_json = *ff::get_parsed_json_from_table(db, "topics", "identifier", db_json.at("topic_id").get<std::string>());
 			if (topic_json.empty()) {
                 nlohmann::json ret;
                 ret["error_str"] = "Topic not found";
@@ -4402,9 +4323,7 @@ limhamn::http::server::response ff::handle_api_close_post_endpoint(const limhamn
             }
 		}
 
-		db_json["open"] = open;
-
-		ff::set_json_in_table(db, "posts", "identifier", post_id, db_json.dump());
+		ff::patch_json_in_table(db, "posts", "identifier", post_id, {{ff::JsonPatchOperation::Set, {"open"}, open}});
 	} catch (const std::exception&) {
 		nlohmann::json ret;
 		ret["error_str"] = "Topic not found";
@@ -4426,6 +4345,7 @@ limhamn::http::server::response ff::handle_api_get_posts_endpoint(const limhamn:
 	std::vector<std::string> ids{};
 	int start_index{};
 	int end_index = -1;
+	ff::PageRequest page{};
 
     try {
 		nlohmann::json input_json = nlohmann::json::parse(request.body);
@@ -4445,36 +4365,56 @@ limhamn::http::server::response ff::handle_api_get_posts_endpoint(const limhamn:
         if (input_json.contains("end_index") && input_json.at("end_index").is_number_integer()) {
             end_index = input_json.at("end_index").get<int>();
         }
+
+        page = ff::parse_page_request(input_json, false);
+    } catch (const std::invalid_argument& e) {
+        nlohmann::json ret;
+        ret["error_str"] = "Invalid pagination: " + std::string(e.what());
+        ret["error"] = "FF_INVALID_JSON";
+        response.http_status = 400;
+        response.body = ret.dump();
+        return response;
     } catch (const std::exception&) {}
 
+    // start_index and end_index predate cursors; end_index is turned into the page limit
+    if (page.limit == 0 && end_index >= 0) {
+        page.limit = static_cast<std::size_t>(std::max(end_index - std::max(start_index, 0) + 1, 1));
+    }
+
     nlohmann::json json;
 	json["posts"] = nlohmann::json::array();
+	json["next_cursor"] = nullptr;
 
     try {
-    	auto contents = db.query("SELECT * FROM posts");
-
-    	int i{};
-    	for (const auto& it : contents) {
-    		if (i < start_index) {
-    			++i;
-    			continue;
-    		}
-    		if (end_index >= 0 && i > end_index) {
-    			break;
-    		}
+    	std::string where{};
+    	std::vector<ff::DatabaseParameter> parameters{};
+    	for (const auto& it : ids) {
+    		where += (where.empty() ? " WHERE identifier IN (?" : ", ?");
+    		parameters.emplace_back(it);
+    	}
+    	if (!where.empty()) {
+    		where += ")";
+    	}
 
-    		const auto db_json = nlohmann::json::parse(it.at("json"));
+    	int skipped{0};
+    	const std::string next_cursor = ff::for_each_row_in_page(db, "posts", {"version"}, where, parameters, page, [&](const std::unordered_map<std::string, std::string>& it) -> bool {
+    		const auto parsed = ff::get_parsed_json_from_row("posts", it);
+    		const auto& db_json = *parsed;
 
     		if (!db_json.contains("identifier") || !db_json.at("identifier").is_string()) {
-    			continue;
+    			return false;
     		}
-
-    		if (!ids.empty() && std::find(ids.begin(), ids.end(), db_json.at("identifier").get<std::string>()) == ids.end()) {
-    			continue; // skip if the identifier is not in the list of ids
+    		if (skipped < start_index) {
+    			++skipped;
+    			return false;
     		}
 
     		json["posts"].push_back(db_json);
-    		++i;
+    		return true;
+    	});
+
+    	if (!next_cursor.empty()) {
+    		json["next_cursor"] = next_cursor;
     	}
     } catch (const std::exception& e) {
         nlohmann::json ret;
@@ -4580,7 +4520,7 @@ limhamn::http::server::response ff::handle_api_edit_post_endpoint(const limhamn:
     }
 
 	try {
-		nlohmann::json db_json = nlohmann::json::parse(ff::get_json_from_table(db, "posts", "identifier", post_id));
+		nlohmann::json db_json = *ff::get_parsed_json_from_table(db, "posts", "identifier", post_id);
 		if (db_json.empty()) {
             nlohmann::json ret;
             ret["error_str"] = "Post not found";
@@ -4610,7 +4550,7 @@ limhamn::http::server::response ff::handle_api_edit_post_endpoint(const limhamn:
         }
 
 		if (db_json.find("topic_id") != db_json.end() && db_json.at("topic_id").is_string()) {
-            nlohmann::json topic_json = nlohmann::json::parse(ff::get_json_from_table(db, "topics", "identifier", db_json.at("topic_id").get<std::string>()));
+            nlohmann::json topic_json = *ff::get_parsed_json_from_table(db, "topics", "identifier", db_json.at("topic_id").get<std::string>());
             if (topic_json.empty()) {
                 nlohmann::json ret;
                 ret["error_str"] = "Topic not found";
@@ -4630,14 +4570,15 @@ limhamn::http::server::response ff::handle_api_edit_post_endpoint(const limhamn:
             }
         }
 
+		std::vector<ff::JsonPatch> patches{};
 		if (json.contains("title") && json.at("title").is_string()) {
-            db_json["title"] = limhamn::http::utils::htmlspecialchars(json.at("title").get<std::string>());
+            patches.push_back({ff::JsonPatchOperation::Set, {"title"}, limhamn::http::utils::htmlspecialchars(json.at("title").get<std::string>())});
         }
 		if (json.contains("text") && json.at("text").is_string()) {
-            db_json["text"] = limhamn::http::utils::htmlspecialchars(json.at("text").get<std::string>());
+            patches.push_back({ff::JsonPatchOperation::Set, {"text"}, limhamn::http::utils::htmlspecialchars(json.at("text").get<std::string>())});
         }
 
-		ff::set_json_in_table(db, "posts", "identifier", post_id, db_json.dump());
+		ff::patch_json_in_table(db, "posts", "identifier", post_id, patches);
 
 		nlohmann::json ret;
 		ret["post_id"] = post_id;
@@ -4761,7 +4702,7 @@ limhamn::http::server::response ff::handle_api_delete_comment_post_endpoint(cons
     }
 
 	try {
-		nlohmann::json db_json = nlohmann::json::parse(ff::get_json_from_table(db, "posts", "identifier", post_id));
+		nlohmann::json db_json = *ff::get_parsed_json_from_table(db, "posts", "identifier", post_id);
 		if (db_json.empty()) {
 			nlohmann::json ret;
 			ret["error_str"] = "Post not found";
@@ -4781,7 +4722,7 @@ limhamn::http::server::response ff::handle_api_delete_comment_post_endpoint(cons
 		}
 
 		if (db_json.find("topic_id") != db_json.end() && db_json.at("topic_id").is_string()) {
-			nlohmann::json topic_json = nlohmann::json::parse(ff::get_json_from_table(db, "topics", "identifier", db_json.at("topic_id").get<std::string>()));
+			nlohmann::json topic_json = *ff::get_parsed_json_from_table(db, "topics", "identifier", db_json.at("topic_id").get<std::string>());
 			if (topic_json.empty()) {
 				nlohmann::json ret;
 				ret["error_str"] = "Topic not found";
@@ -4802,18 +4743,24 @@ limhamn::http::server::response ff::handle_api_delete_comment_post_endpoint(cons
 		}
 
 		if (db_json.find("comments") != db_json.end() && db_json.at("comments").is_array()) {
-            auto& comments = db_json["comments"];
-			bool found = false;
-			for (size_t i = 0; i < comments.size(); ++i) {
-				if (i == static_cast<size_t>(comment_id) &&
-					((comments[i].contains("created_by") && comments[i].at("created_by").get<std::string>() == username)
-					|| get_user_type(db, username) == ff::UserType::Administrator))  {
-					found = true;
-					comments.erase(i);
-
-					break;
+			const bool administrator = get_user_type(db, username) == ff::UserType::Administrator;
+
+			// the owner is checked against the comments as they are written, not as they were read above
+			const bool found = ff::update_json_in_table(db, "posts", "identifier", post_id, [&](nlohmann::json& current) -> bool {
+				if (!current.contains("comments") || !current.at("comments").is_array()) {
+					return false;
 				}
-			}
+
+				auto& comments = current.at("comments");
+				const auto i = static_cast<size_t>(comment_id);
+				if (i >= comments.size() ||
+					!((comments[i].contains("created_by") && comments[i].at("created_by").get<std::string>() == username) || administrator)) {
+					return false;
+				}
+
+				comments.erase(i);
+				return true;
+			});
 			if (!found) {
                 nlohmann::json ret;
                 ret["error_str"] = "Comment not found";
@@ -4831,9 +4778,6 @@ limhamn::http::server::response ff::handle_api_delete_comment_post_endpoint(cons
             return response;
         }
 
-		// reinsert
-		ff::set_json_in_table(db, "posts", "identifier", post_id, db_json.dump());
-
 		nlohmann::json ret;
 		response.http_status = 204;
 		response.body = "";
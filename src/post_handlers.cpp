@@ -1,4 +1,5 @@
 #include <ff.hpp>
+#include <multipart_parser.hpp>
 #include <scrypto.hpp>
 #include <limhamn/http/http_utils.hpp>
 #include <nlohmann/json.hpp>
@@ -41,7 +42,16 @@ limhamn::http::server::response ff::handle_try_upload_post_endpoint(const limham
     logger.write_to_log(limhamn::logger::type::notice, "Attempting to upload a file.\n");
 #endif
 
-    const auto file_handles = limhamn::http::utils::parse_multipart_form_file(req.raw_body, settings.temp_directory + "/%f-%h-%r");
+    const auto [multipart_status, file_handles] = ff::parse_multipart_form(req, ff::MultipartLimits{
+        .max_part_size = static_cast<std::uintmax_t>(settings.max_request_size),
+        .part_limits = {
+            {"json", settings.max_json_part_size},
+        },
+    });
+    if (multipart_status != ff::MultipartStatus::Success) {
+        return ff::make_multipart_error_response(multipart_status);
+    }
+
     for (const auto& it : file_handles) {
 #ifdef FF_DEBUG
         logger.write_to_log(limhamn::logger::type::notice, "File name: " + it.filename + ", Name: " + it.name + "\n");
@@ -156,7 +166,7 @@ limhamn::http::server::response ff::handle_try_upload_post_endpoint(const limham
 
     const auto check_if_topic_exists = [&db, &topic_id]() -> bool {
         try {
-            nlohmann::json db_json = nlohmann::json::parse(ff::get_json_from_table(db, "topics", "identifier", topic_id));
+            nlohmann::json db_json = *ff::get_parsed_json_from_table(db, "topics", "identifier", topic_id);
             return !db_json.empty();
         } catch (const std::exception&) {
             return false;
@@ -174,7 +184,7 @@ limhamn::http::server::response ff::handle_try_upload_post_endpoint(const limham
 
 	const auto check_if_post_exists = [&db, &post_id]() -> bool {
         try {
-            nlohmann::json db_json = nlohmann::json::parse(ff::get_json_from_table(db, "posts", "identifier", post_id));
+            nlohmann::json db_json = *ff::get_parsed_json_from_table(db, "posts", "identifier", post_id);
             return !db_json.empty();
         } catch (const std::exception&) {
             return false;
@@ -228,7 +238,7 @@ limhamn::http::server::response ff::handle_try_upload_post_endpoint(const limham
 
 	// insert to db
 	try {
-		nlohmann::json topic_json = nlohmann::json::parse(ff::get_json_from_table(db, "topics", "identifier", topic_id));
+		nlohmann::json topic_json = *ff::get_parsed_json_from_table(db, "topics", "identifier", topic_id);
 
 		if (topic_json.empty()) {
 			nlohmann::json ret;
@@ -247,18 +257,13 @@ limhamn::http::server::response ff::handle_try_upload_post_endpoint(const limham
 			return response;
 		}
 
-		if (topic_json.find("posts") == topic_json.end() || !topic_json.at("posts").is_array()) {
-			topic_json["posts"] = nlohmann::json::array();
-		}
-		topic_json["posts"].push_back(post_id);
-
 		ff::logger.write_to_log(limhamn::logger::type::notice, "Inserting post with ID: " + post_id + " into the database.\n");
 
 		db.exec("INSERT INTO posts (identifier, json) VALUES (?, ?);", post_id, db_json.dump());
 
 		ff::logger.write_to_log(limhamn::logger::type::notice, "Post with ID: " + post_id + " inserted into the database.\n");
 
-		ff::set_json_in_table(db, "topics", "identifier", topic_id, topic_json.dump());
+		ff::patch_json_in_table(db, "topics", "identifier", topic_id, {{ff::JsonPatchOperation::Append, {"posts"}, post_id}});
 	} catch (const std::exception& e) {
 		nlohmann::json ret;
 		ret["error_str"] = "Failed to create post: " + std::string(e.what());
@@ -316,7 +321,16 @@ limhamn::http::server::response ff::handle_try_upload_post_comment_endpoint(cons
     logger.write_to_log(limhamn::logger::type::notice, "Attempting to upload a file.\n");
 #endif
 
-    const auto file_handles = limhamn::http::utils::parse_multipart_form_file(req.raw_body, settings.temp_directory + "/%f-%h-%r");
+    const auto [multipart_status, file_handles] = ff::parse_multipart_form(req, ff::MultipartLimits{
+        .max_part_size = static_cast<std::uintmax_t>(settings.max_request_size),
+        .part_limits = {
+            {"json", settings.max_json_part_size},
+        },
+    });
+    if (multipart_status != ff::MultipartStatus::Success) {
+        return ff::make_multipart_error_response(multipart_status);
+    }
+
     for (const auto& it : file_handles) {
 #ifdef FF_DEBUG
         logger.write_to_log(limhamn::logger::type::notice, "File name: " + it.filename + ", Name: " + it.name + "\n");
@@ -425,7 +439,7 @@ limhamn::http::server::response ff::handle_try_upload_post_comment_endpoint(cons
 	}
 
 	try {
-		nlohmann::json db_json = nlohmann::json::parse(ff::get_json_from_table(db, "posts", "identifier", post_id));
+		nlohmann::json db_json = *ff::get_parsed_json_from_table(db, "posts", "identifier", post_id);
 		if (db_json.empty()) {
 			nlohmann::json ret;
 			ret["error_str"] = "Post not found";
@@ -445,7 +459,7 @@ limhamn::http::server::response ff::handle_try_upload_post_comment_endpoint(cons
 		}
 
 		if (db_json.find("topic_id") != db_json.end() && db_json.at("topic_id").is_string()) {
-			nlohmann::json topic_json = nlohmann::json::parse(ff::get_json_from_table(db, "topics", "identifier", db_json.at("topic_id").get<std::string>()));
+			nlohmann::json topic_json = *ff::get_parsed_json_from_table(db, "topics", "identifier", db_json.at("topic_id").get<std::string>());
 			if (topic_json.empty()) {
 				nlohmann::json ret;
 				ret["error_str"] = "Topic not found";
@@ -465,10 +479,6 @@ limhamn::http::server::response ff::handle_try_upload_post_comment_endpoint(cons
 			}
 		}
 
-		if (db_json.find("comments") == db_json.end() || !db_json.at("comments").is_array()) {
-            db_json["comments"] = nlohmann::json::array();
-        }
-
 		nlohmann::json comment_json;
 
 		comment_json["comment"] = limhamn::http::utils::htmlspecialchars(comment);
@@ -499,9 +509,7 @@ limhamn::http::server::response ff::handle_try_upload_post_comment_endpoint(cons
 			});
 		}
 
-		db_json["comments"].push_back(comment_json);
-
-		ff::set_json_in_table(db, "posts", "identifier", post_id, db_json.dump());
+		ff::patch_json_in_table(db, "posts", "identifier", post_id, {{ff::JsonPatchOperation::Append, {"comments"}, comment_json}});
 
 		nlohmann::json ret;
 		ret["post_id"] = post_id;
@@ -0,0 +1,44 @@
+#include <ff.hpp>
+#include <profile_cache.hpp>
+
+std::optional<ff::Profile> ff::ProfileCache::find(const std::string& username) {
+    std::lock_guard<std::mutex> lock{this->mutex};
+
+    const auto it = this->entries.find(username);
+    if (it == this->entries.end()) {
+        return std::nullopt;
+    }
+    if (it->second.expires_at <= std::chrono::steady_clock::now()) {
+        this->entries.erase(it);
+        return std::nullopt;
+    }
+
+    return it->second.profile;
+}
+
+void ff::ProfileCache::insert(const std::string& username, const Profile& profile) {
+    if (settings.profile_cache_ttl <= 0 || settings.profile_cache_size == 0) {
+        return;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lock{this->mutex};
+
+    // make room by dropping expired entries first, and then whichever comes first
+    if (this->entries.size() >= settings.profile_cache_size && this->entries.find(username) == this->entries.end()) {
+        for (auto it = this->entries.begin(); it != this->entries.end();) {
+            it = it->second.expires_at <= now ? this->entries.erase(it) : std::next(it);
+        }
+        if (this->entries.size() >= settings.profile_cache_size) {
+            this->entries.erase(this->entries.begin());
+        }
+    }
+
+    this->entries[username] = Entry{profile, now + std::chrono::milliseconds{settings.profile_cache_ttl}};
+}
+
+void ff::ProfileCache::invalidate(const std::string& username) {
+    std::lock_guard<std::mutex> lock{this->mutex};
+    this->entries.erase(username);
+}
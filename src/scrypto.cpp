@@ -64,8 +64,8 @@ std::string scrypto::generate_random_string(const int length) {
         "abcdefghijklmnopqrstuvwxyz";
 
     static constexpr size_t charset_size = sizeof(charset) - 1;
-    static std::random_device rd;
-    static std::mt19937 generator(rd());
+    thread_local std::random_device rd;
+    thread_local std::mt19937 generator(rd());
 
     std::uniform_int_distribution<> distribution(0, charset_size - 1);
 
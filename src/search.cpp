@@ -0,0 +1,54 @@
+#include <cctype>
+#include <vector>
+#include <search.hpp>
+
+namespace {
+    // words are runs of ASCII letters and digits or non-ASCII bytes, which both tokenizers keep together
+    std::vector<std::string> get_words(const std::string& input) {
+        std::vector<std::string> words{};
+        std::string word{};
+
+        for (const auto& c : input) {
+            const auto byte = static_cast<unsigned char>(c);
+            if (byte >= 0x80 || std::isalnum(byte)) {
+                word += static_cast<char>(byte < 0x80 ? std::tolower(byte) : byte);
+                continue;
+            }
+            if (!word.empty()) {
+                words.push_back(std::move(word));
+                word.clear();
+            }
+        }
+        if (!word.empty()) {
+            words.push_back(std::move(word));
+        }
+
+        return words;
+    }
+}
+
+std::string ff::make_search_query(const std::string& input, const bool postgres) {
+    std::string query{};
+
+    // words only contain letters and digits, so quoting them is enough to make them safe
+    for (const auto& it : get_words(input)) {
+        if (postgres) {
+            query += (query.empty() ? "'" : " & '") + it + "':*";
+        } else {
+            query += (query.empty() ? "\"" : " \"") + it + "\"*";
+        }
+    }
+
+    return query;
+}
+
+std::string ff::get_search_source(const std::string& table, const bool postgres) {
+    if (postgres) {
+        return "(SELECT " + table + ".*, CAST(round(ts_rank(" + table + ".search, search_query) * 1000000) AS bigint) AS rank FROM " + table +
+            ", to_tsquery('simple', ?) AS search_query WHERE " + table + ".search @@ search_query) AS " + table;
+    }
+
+    // bm25() is lower for better matches; titles weigh the most, descriptions the least
+    return "(SELECT " + table + ".*, CAST(round(-bm25(" + table + "_search, 10.0, 10.0, 5.0, 5.0, 1.0) * 1000000) AS INTEGER) AS rank FROM " + table + "_search JOIN " + table +
+        " ON " + table + ".id = " + table + "_search.rowid WHERE " + table + "_search MATCH ?) AS " + table;
+}
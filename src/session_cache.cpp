@@ -0,0 +1,78 @@
+#include <ff.hpp>
+#include <session_cache.hpp>
+
+ff::SessionCache::Shard& ff::SessionCache::get_shard(const std::string& username) {
+    return this->shards[std::hash<std::string>{}(username) % this->shards.size()];
+}
+
+std::optional<ff::CachedSession> ff::SessionCache::find(const std::string& username, const std::string& key) {
+    auto& shard = this->get_shard(username);
+    std::lock_guard<std::mutex> lock{shard.mutex};
+
+    const auto it = shard.entries.find(username);
+    if (it == shard.entries.end() || it->second.key != key) {
+        return std::nullopt;
+    }
+    if (it->second.expires_at <= std::chrono::steady_clock::now()) {
+        shard.entries.erase(it);
+        return std::nullopt;
+    }
+
+    return it->second.session;
+}
+
+std::optional<ff::CachedSession> ff::SessionCache::find(const std::string& username) {
+    auto& shard = this->get_shard(username);
+    std::lock_guard<std::mutex> lock{shard.mutex};
+
+    const auto it = shard.entries.find(username);
+    if (it == shard.entries.end() || it->second.expires_at <= std::chrono::steady_clock::now()) {
+        return std::nullopt;
+    }
+
+    return it->second.session;
+}
+
+uint64_t ff::SessionCache::get_generation(const std::string& username) {
+    auto& shard = this->get_shard(username);
+    std::lock_guard<std::mutex> lock{shard.mutex};
+
+    return shard.generation;
+}
+
+void ff::SessionCache::insert(const std::string& username, const std::string& key, const CachedSession& session, const uint64_t generation) {
+    if (settings.session_cache_ttl <= 0 || settings.session_cache_size == 0) {
+        return;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    const std::size_t capacity = std::max<std::size_t>(settings.session_cache_size / this->shards.size(), 1);
+
+    auto& shard = this->get_shard(username);
+    std::lock_guard<std::mutex> lock{shard.mutex};
+
+    // an invalidation while the users table was being read may have made the result stale
+    if (shard.generation != generation) {
+        return;
+    }
+
+    // make room by dropping expired entries first, and then whichever comes first
+    if (shard.entries.size() >= capacity && shard.entries.find(username) == shard.entries.end()) {
+        for (auto it = shard.entries.begin(); it != shard.entries.end();) {
+            it = it->second.expires_at <= now ? shard.entries.erase(it) : std::next(it);
+        }
+        if (shard.entries.size() >= capacity) {
+            shard.entries.erase(shard.entries.begin());
+        }
+    }
+
+    shard.entries[username] = Entry{key, session, now + std::chrono::milliseconds{settings.session_cache_ttl}};
+}
+
+void ff::SessionCache::invalidate(const std::string& username) {
+    auto& shard = this->get_shard(username);
+    std::lock_guard<std::mutex> lock{shard.mutex};
+
+    shard.entries.erase(username);
+    ++shard.generation;
+}
@@ -0,0 +1,130 @@
+#include <chrono>
+#include <csignal>
+#include <cerrno>
+#include <thread>
+#include <unordered_map>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <ff.hpp>
+
+namespace {
+    volatile std::sig_atomic_t stopping{0};
+
+    void handle_signal(const int) {
+        stopping = 1;
+    }
+
+    struct Worker {
+        std::size_t index{0};
+        std::chrono::steady_clock::time_point started_at{};
+        std::chrono::seconds backoff{0};
+    };
+
+    pid_t spawn_worker(const std::size_t index) {
+        const pid_t pid = fork();
+
+        if (pid == 0) {
+            std::signal(SIGTERM, SIG_DFL);
+            std::signal(SIGINT, SIG_DFL);
+            ff::is_supervised_worker = true;
+
+            // limhamn cannot set SO_REUSEPORT, so each worker listens on a port of its own
+            ff::settings.port += static_cast<int>(index);
+            ff::logger.write_to_log(limhamn::logger::type::notice, "Worker " + std::to_string(index) + " is now running on port " + std::to_string(ff::settings.port) + ".\n");
+
+            ff::start_server();
+            std::exit(EXIT_SUCCESS);
+        }
+
+        if (pid < 0) {
+            ff::logger.write_to_log(limhamn::logger::type::error, "Failed to fork worker " + std::to_string(index) + ".\n");
+        }
+
+        return pid;
+    }
+}
+
+void ff::run_supervisor(const std::size_t workers) {
+    // set up the schema once, before any worker exists, so they never race to migrate it
+    try {
+        ff::setup_database(*ff::open_database());
+    } catch (const std::exception& e) {
+        ff::logger.write_to_log(limhamn::logger::type::error, "An error occurred: " + std::string{e.what()} + "\n");
+        std::exit(EXIT_FAILURE);
+    }
+
+    struct sigaction action{};
+    action.sa_handler = handle_signal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGTERM, &action, nullptr);
+    sigaction(SIGINT, &action, nullptr);
+
+    std::unordered_map<pid_t, Worker> running{};
+
+    for (std::size_t i{0}; i < workers; ++i) {
+        if (const pid_t pid = spawn_worker(i); pid > 0) {
+            running[pid] = Worker{.index = i, .started_at = std::chrono::steady_clock::now(), .backoff = {}};
+        }
+    }
+
+    int exit_status{EXIT_SUCCESS};
+
+    while (!running.empty() && !stopping) {
+        int status{0};
+        const pid_t pid = waitpid(-1, &status, 0);
+
+        if (pid < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+
+        const auto it = running.find(pid);
+        if (it == running.end()) {
+            continue;
+        }
+
+        Worker worker = it->second;
+        running.erase(it);
+
+        // a worker that exits on its own has halted on purpose (halt_on_error or a fatal error), so stop them all
+        if (WIFEXITED(status)) {
+            if (WEXITSTATUS(status) != EXIT_SUCCESS) {
+                ff::logger.write_to_log(limhamn::logger::type::error, "Worker " + std::to_string(worker.index) + " halted, stopping all workers.\n");
+                exit_status = EXIT_FAILURE;
+                break;
+            }
+            continue;
+        }
+
+        ff::logger.write_to_log(limhamn::logger::type::warning, "Worker " + std::to_string(worker.index) + " was killed by signal " + std::to_string(WTERMSIG(status)) + ", restarting it.\n");
+
+        // back off when a worker keeps crashing right after it starts
+        if (std::chrono::steady_clock::now() - worker.started_at < std::chrono::seconds{10}) {
+            worker.backoff = std::min(std::max(worker.backoff * 2, std::chrono::seconds{1}), std::chrono::seconds{30});
+            std::this_thread::sleep_for(worker.backoff);
+        } else {
+            worker.backoff = {};
+        }
+
+        if (stopping) {
+            break;
+        }
+
+        if (const pid_t new_pid = spawn_worker(worker.index); new_pid > 0) {
+            worker.started_at = std::chrono::steady_clock::now();
+            running[new_pid] = worker;
+        }
+    }
+
+    for (const auto& it : running) {
+        kill(it.first, SIGTERM);
+    }
+    for (const auto& it : running) {
+        waitpid(it.first, nullptr, 0);
+    }
+
+    std::exit(exit_status);
+}
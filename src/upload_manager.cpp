@@ -1,6 +1,8 @@
 #include <filesystem>
 #include <scrypto.hpp>
 #include <ff.hpp>
+#include <multipart_parser.hpp>
+#include <metrics.hpp>
 #include <nlohmann/json.hpp>
 #include <limhamn/http/http_utils.hpp>
 #include <wad_info.hpp>
@@ -30,7 +32,22 @@ std::pair<ff::UploadStatus, std::string> ff::try_upload_forwarder(const limhamn:
     logger.write_to_log(limhamn::logger::type::notice, "Attempting to upload a file.\n");
 #endif
 
-    const auto file_handles = limhamn::http::utils::parse_multipart_form_file(req.raw_body, settings.temp_directory + "/%f-%h-%r");
+    ff::UploadStageTimer timer{ff::UploadStage::Multipart};
+
+    const auto [multipart_status, file_handles] = ff::parse_multipart_form(req, ff::MultipartLimits{
+        .max_part_size = static_cast<std::uintmax_t>(settings.max_request_size),
+        .part_limits = {
+            {"json", settings.max_json_part_size},
+            {"banner", settings.max_image_part_size},
+            {"icon", settings.max_image_part_size},
+        },
+    });
+    if (multipart_status == ff::MultipartStatus::TooLarge) {
+        return {ff::UploadStatus::TooLarge, ""};
+    } else if (multipart_status != ff::MultipartStatus::Success) {
+        return {ff::UploadStatus::Failure, ""};
+    }
+
     for (const auto& it : file_handles) {
 #ifdef FF_DEBUG
         logger.write_to_log(limhamn::logger::type::notice, "File name: " + it.filename + ", Name: " + it.name + "\n");
@@ -64,6 +81,8 @@ std::pair<ff::UploadStatus, std::string> ff::try_upload_forwarder(const limhamn:
         return {ff::UploadStatus::Failure, ""};
     }
 
+    timer.next(ff::UploadStage::Wad);
+
     ff::WADInfo wad_info;
     try {
         wad_info = ff::get_info_from_wad(wad_path);
@@ -96,8 +115,6 @@ std::pair<ff::UploadStatus, std::string> ff::try_upload_forwarder(const limhamn:
     }
 
     db_json["uploader"] = username;
-    db_json["ratings"] = nlohmann::json::object();
-    db_json["reviews"] = nlohmann::json::array();
     db_json["submitted"] = scrypto::return_unix_millis();
     db_json["downloads"] = 0;
     db_json["needs_review"] = get_user_type(db, username) != UserType::Administrator;
@@ -248,6 +265,8 @@ std::pair<ff::UploadStatus, std::string> ff::try_upload_forwarder(const limhamn:
         }
     }
 
+    timer.next(ff::UploadStage::Media);
+
     std::string banner_ext{};
     std::string icon_ext{};
     try {
@@ -304,6 +323,8 @@ std::pair<ff::UploadStatus, std::string> ff::try_upload_forwarder(const limhamn:
         return {ff::UploadStatus::Failure, ""};
     }
 
+    timer.next(ff::UploadStage::Store);
+
     const std::string banner_key = ff::upload_file(db, FileConstruct{
         .path = banner_path,
         .name = "banner" + banner_ext,
@@ -382,6 +403,8 @@ std::pair<ff::UploadStatus, std::string> ff::try_upload_forwarder(const limhamn:
         return {ff::UploadStatus::Failure, ""};
     }
 
+    timer.next(ff::UploadStage::Thumbnail);
+
     db_json["banner_download_key"] = banner_key;
     if (!validate_video(banner_path)) {
         db_json["banner_thumbnail_download_key"] = banner_key;
@@ -432,6 +455,8 @@ std::pair<ff::UploadStatus, std::string> ff::try_upload_forwarder(const limhamn:
         db_json["icon_type"] = "video";
     }
 
+    timer.next(ff::UploadStage::Store);
+
     db_json["icon_download_key"] = icon_key;
     db_json["data_download_key"] = data_key;
 
@@ -442,7 +467,7 @@ std::pair<ff::UploadStatus, std::string> ff::try_upload_forwarder(const limhamn:
     while (!db.query("SELECT * FROM forwarders WHERE identifier = ?;", page_identifier).empty()) {
         page_identifier = scrypto::generate_random_string(8);
     }
-    if (!db.exec("INSERT INTO forwarders (identifier, json) VALUES (?, ?);", page_identifier, db_json.dump())) {
+    if (!ff::insert_json_into_table(db, "forwarders", "identifier", page_identifier, db_json.dump())) {
         return {ff::UploadStatus::Failure, ""};
     }
 
@@ -476,7 +501,20 @@ std::pair<ff::UploadStatus, std::string> ff::try_upload_file(const limhamn::http
     logger.write_to_log(limhamn::logger::type::notice, "Attempting to upload a file.\n");
 #endif
 
-    const auto file_handles = limhamn::http::utils::parse_multipart_form_file(req.raw_body, settings.temp_directory + "/%f-%h-%r");
+    ff::UploadStageTimer timer{ff::UploadStage::Multipart};
+
+    const auto [multipart_status, file_handles] = ff::parse_multipart_form(req, ff::MultipartLimits{
+        .max_part_size = static_cast<std::uintmax_t>(settings.max_request_size),
+        .part_limits = {
+            {"json", settings.max_json_part_size},
+        },
+    });
+    if (multipart_status == ff::MultipartStatus::TooLarge) {
+        return {ff::UploadStatus::TooLarge, ""};
+    } else if (multipart_status != ff::MultipartStatus::Success) {
+        return {ff::UploadStatus::Failure, ""};
+    }
+
     for (const auto& it : file_handles) {
 #ifdef FF_DEBUG
         logger.write_to_log(limhamn::logger::type::notice, "File name: " + it.filename + ", Name: " + it.name + "\n");
@@ -526,8 +564,6 @@ std::pair<ff::UploadStatus, std::string> ff::try_upload_file(const limhamn::http
     }
 
     db_json["uploader"] = username;
-    db_json["ratings"] = nlohmann::json::object();
-    db_json["reviews"] = nlohmann::json::array();
     db_json["submitted"] = scrypto::return_unix_millis();
     db_json["downloads"] = 0;
     db_json["needs_review"] = get_user_type(db, username) != UserType::Administrator;
@@ -578,6 +614,8 @@ std::pair<ff::UploadStatus, std::string> ff::try_upload_file(const limhamn::http
         }
     }
 
+    timer.next(ff::UploadStage::Store);
+
     db_json["data"] = nlohmann::json::array();
     for (const auto& it : fh) {
         std::string data_key = ff::upload_file(db, FileConstruct{
@@ -605,7 +643,7 @@ std::pair<ff::UploadStatus, std::string> ff::try_upload_file(const limhamn::http
     while (!db.query("SELECT * FROM sandbox WHERE identifier = ?;", page_identifier).empty()) {
         page_identifier = scrypto::generate_random_string(8);
     }
-    if (!db.exec("INSERT INTO sandbox (identifier, json) VALUES (?, ?);", page_identifier, db_json.dump())) {
+    if (!ff::insert_json_into_table(db, "sandbox", "identifier", page_identifier, db_json.dump())) {
         return {ff::UploadStatus::Failure, ""};
     }
 
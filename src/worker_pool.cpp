@@ -0,0 +1,65 @@
+#include <worker_pool.hpp>
+
+ff::WorkerPool::WorkerPool(std::vector<std::unique_ptr<database>> connections) : connections(std::move(connections)) {
+    this->threads.reserve(this->connections.size());
+    for (auto& it : this->connections) {
+        this->threads.emplace_back(&WorkerPool::run, this, std::ref(*it));
+    }
+}
+
+ff::WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock{this->mutex};
+        this->stopping = true;
+    }
+    this->condition.notify_all();
+
+    for (auto& it : this->threads) {
+        if (it.joinable()) {
+            it.join();
+        }
+    }
+}
+
+void ff::WorkerPool::run(database& db) {
+    while (true) {
+        Task task{};
+
+        {
+            std::unique_lock<std::mutex> lock{this->mutex};
+            this->condition.wait(lock, [this]() { return this->stopping || !this->tasks.empty(); });
+
+            if (this->tasks.empty()) {
+                return;
+            }
+
+            task = std::move(this->tasks.front());
+            this->tasks.pop_front();
+        }
+
+        task(db);
+    }
+}
+
+limhamn::http::server::response ff::WorkerPool::dispatch(const std::function<limhamn::http::server::response(database&)>& handler) {
+    std::promise<limhamn::http::server::response> promise{};
+    auto future = promise.get_future();
+
+    {
+        std::lock_guard<std::mutex> lock{this->mutex};
+        this->tasks.emplace_back([&handler, &promise](database& db) {
+            try {
+                promise.set_value(handler(db));
+            } catch (...) {
+                promise.set_exception(std::current_exception());
+            }
+        });
+    }
+    this->condition.notify_one();
+
+    return future.get();
+}
+
+std::size_t ff::WorkerPool::size() const {
+    return this->threads.size();
+}